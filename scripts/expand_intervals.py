@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Adds per time step views of Reactor interval output to an SQLite database.
+
+Reactors with ``interval_output`` enabled write ``ReactorPowerIntervals`` and
+``ReactorSideProductIntervals`` (StartTime inclusive, EndTime exclusive)
+instead of the per time step ``TimeSeriesPower``, ``TimeSeriessupplyPOWER``
+and ``ReactorSideProducts`` tables.  This script adds the views
+
+* ``TimeSeriesPowerExpanded`` (SimId, AgentId, Time, Value)
+* ``TimeSeriessupplyPOWERExpanded`` (SimId, AgentId, Time, Value)
+* ``ReactorSideProductsExpanded`` (SimId, AgentId, Time, Product, Value)
+
+with one row per time step so that existing analysis scripts only need to
+change the table name they read from.  Running it again is harmless.
+
+Usage::
+
+    $ python3 expand_intervals.py cyclus.sqlite
+"""
+import argparse
+import sqlite3
+
+
+POWER_VIEW = """
+CREATE VIEW IF NOT EXISTS {name} AS
+  WITH RECURSIVE steps(SimId, AgentId, Time, EndTime, Value) AS (
+    SELECT SimId, AgentId, StartTime, EndTime, Value
+      FROM ReactorPowerIntervals
+    UNION ALL
+    SELECT SimId, AgentId, Time + 1, EndTime, Value
+      FROM steps WHERE Time + 1 < EndTime)
+  SELECT SimId, AgentId, Time, Value FROM steps;
+"""
+
+# TimeSeriesPower and TimeSeriessupplyPOWER always hold the same values, so
+# both are expanded from ReactorPowerIntervals.
+VIEWS = {
+    'ReactorPowerIntervals': [
+        POWER_VIEW.format(name='TimeSeriesPowerExpanded'),
+        POWER_VIEW.format(name='TimeSeriessupplyPOWERExpanded'),
+    ],
+    'ReactorSideProductIntervals': ["""
+CREATE VIEW IF NOT EXISTS ReactorSideProductsExpanded AS
+  WITH RECURSIVE steps(SimId, AgentId, Time, EndTime, Product, Value) AS (
+    SELECT SimId, AgentId, StartTime, EndTime, Product, Value
+      FROM ReactorSideProductIntervals
+    UNION ALL
+    SELECT SimId, AgentId, Time + 1, EndTime, Product, Value
+      FROM steps WHERE Time + 1 < EndTime)
+  SELECT SimId, AgentId, Time, Product, Value FROM steps;
+"""],
+}
+
+
+def expand_intervals(conn):
+    """Creates the expanded views for every interval table present in conn
+    and returns the names of the tables that were expanded.
+    """
+    tables = set(r[0] for r in conn.execute(
+        "SELECT name FROM sqlite_master WHERE type = 'table'"))
+    expanded = []
+    for table, views in sorted(VIEWS.items()):
+        if table in tables:
+            for sql in views:
+                conn.execute(sql)
+            expanded.append(table)
+    conn.commit()
+    return expanded
+
+
+def main(args=None):
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument('db', help='cyclus SQLite output file')
+    ns = p.parse_args(args)
+    conn = sqlite3.connect(ns.db)
+    try:
+        expanded = expand_intervals(conn)
+    finally:
+        conn.close()
+    if not expanded:
+        print('no Reactor interval tables found in ' + ns.db)
+    for table in expanded:
+        print('expanded ' + table)
+
+
+if __name__ == '__main__':
+    main()
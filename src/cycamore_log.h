@@ -0,0 +1,28 @@
+#ifndef CYCAMORE_SRC_CYCAMORE_LOG_H_
+#define CYCAMORE_SRC_CYCAMORE_LOG_H_
+
+#include "logger.h"
+
+/// The most verbose log level compiled into CYCAMORE_LOG statements.
+/// Statements above it are constant-folded away; the rest are filtered at run
+/// time by cyclus::Logger::ReportLevel() exactly like cyclus' LOG. Set it with
+/// the CYCAMORE_MAX_LOG_LEVEL CMake option, e.g.
+/// -DCYCAMORE_MAX_LOG_LEVEL=LEV_INFO3.
+#ifndef CYCAMORE_MAX_LOG_LEVEL
+#define CYCAMORE_MAX_LOG_LEVEL cyclus::LEV_DEBUG5
+#endif
+
+/// true if a statement at the given level is both compiled in and reported
+#define CYCAMORE_LOG_ENABLED(level) \
+  ((level) <= CYCAMORE_MAX_LOG_LEVEL && \
+   (level) <= cyclus::Logger::ReportLevel())
+
+/// cyclus' LOG macro plus the CYCAMORE_MAX_LOG_LEVEL cap. LOG already skips
+/// its arguments when the level is not reported, so this only pays off in
+/// per-trade paths whose verbose statements should not be compiled in at all;
+/// everywhere else plain LOG is fine.
+#define CYCAMORE_LOG(level, prefix) \
+  if (!CYCAMORE_LOG_ENABLED(level)) {} \
+  else cyclus::Logger().Get(level, prefix)
+
+#endif  // CYCAMORE_SRC_CYCAMORE_LOG_H_
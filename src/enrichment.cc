@@ -9,10 +9,135 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include "cycamore_log.h"
+
 using cyclus::Material;
 
 namespace cycamore {
 
+// U-235 fraction of the U-235 + U-238 in a composition's basis map, i.e.
+// UraniumAssayMass/UraniumAssayAtom without building a material or MatQuery
+static double UAssay(const cyclus::CompMap& cm) {
+  cyclus::CompMap::const_iterator it = cm.find(922350000);
+  double u235 = it != cm.end() ? it->second : 0;
+  it = cm.find(922380000);
+  double u238 = it != cm.end() ? it->second : 0;
+  return u235 + u238 > 0 ? u235 / (u235 + u238) : 0;
+}
+
+// value function of the separation potential
+static double SepPotential(double x) {
+  return (2 * x - 1) * std::log(x / (1 - x));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const Cascade::Solution& Cascade::Solve(double feed, double product,
+                                        double tails) const {
+  Key k(feed, std::make_pair(product, tails));
+  std::map<Key, Entry>::iterator it = solutions_.find(k);
+  if (it != solutions_.end()) {
+    by_use_.erase(it->second.last_use);
+    it->second.last_use = ++uses_;
+    by_use_[uses_] = k;
+    return it->second.solution;
+  }
+
+  if (solutions_.size() >= capacity_ && !by_use_.empty()) {
+    solutions_.erase(by_use_.begin()->second);
+    by_use_.erase(by_use_.begin());
+  }
+  Entry e;
+  e.solution = Compute(feed, product, tails);
+  e.last_use = ++uses_;
+  by_use_[uses_] = k;
+  return solutions_.insert(std::make_pair(k, e)).first->second.solution;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Cascade::Solution Cascade::Compute(double feed, double product,
+                                   double tails) const {
+  Solution s;
+  s.product = product;
+  s.tails = tails;
+  s.enriching = 0;
+  s.stripping = 0;
+  if (!enabled() || product <= feed || product >= 1 || tails >= feed ||
+      tails <= 0) {
+    cyclus::toolkit::Assays assays(feed, product, tails);
+    s.swu = cyclus::toolkit::SwuRequired(1, assays);
+    s.feed = cyclus::toolkit::FeedQty(1, assays);
+    return s;
+  }
+
+  // whole stages, without adding one when the abundance ratio is an exact
+  // power of beta up to round-off
+  double ln_beta = 0.5 * std::log(alpha_);
+  double r_feed = feed / (1 - feed);
+  s.enriching = static_cast<int>(std::ceil(
+      std::log(product / (1 - product) / r_feed) / ln_beta - 1e-9));
+  s.stripping = static_cast<int>(std::ceil(
+      std::log(r_feed / (tails / (1 - tails))) / ln_beta - 1e-9));
+  double r_product = r_feed * std::exp(s.enriching * ln_beta);
+  double r_tails = r_feed * std::exp(-s.stripping * ln_beta);
+  s.product = r_product / (1 + r_product);
+  s.tails = r_tails / (1 + r_tails);
+
+  // cascade product, feed and tails per kg of product blended down to the
+  // requested assay
+  double p = (product - feed) / (s.product - feed);
+  double f = p * (s.product - s.tails) / (feed - s.tails);
+  double w = f - p;
+  s.swu = p * SepPotential(s.product) + w * SepPotential(s.tails) -
+          f * SepPotential(feed);
+  s.feed = f + (1 - p);
+  return s;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void EnrichTable::Build(const Cascade& cascade, double feed, double p_lo,
+                        double p_hi, int np, double t_lo, double t_hi,
+                        int nt) {
+  feed_ = feed;
+  np_ = std::max(np, 2);
+  nt_ = std::max(nt, 2);
+  p_lo_ = p_lo;
+  dp_ = (p_hi - p_lo) / (np_ - 1);
+  t_lo_ = t_lo;
+  dt_ = (t_hi - t_lo) / (nt_ - 1);
+  vals_.resize(np_ * nt_);
+  for (int i = 0; i < np_; ++i) {
+    for (int j = 0; j < nt_; ++j) {
+      Cascade::Solution s = cascade.Compute(feed, p_lo_ + i * dp_, tails(j));
+      vals_[i * nt_ + j].swu = s.swu;
+      vals_[i * nt_ + j].feed = s.feed;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+EnrichFactors EnrichTable::Lookup(double product, double tails) const {
+  // cell index and fractional position along each axis, clamped to the grid
+  double u = dp_ > 0 ? (product - p_lo_) / dp_ : 0;
+  double v = dt_ > 0 ? (tails - t_lo_) / dt_ : 0;
+  u = std::min(std::max(u, 0.0), np_ - 1.0);
+  v = std::min(std::max(v, 0.0), nt_ - 1.0);
+  int i = std::min(static_cast<int>(u), np_ - 2);
+  int j = std::min(static_cast<int>(v), nt_ - 2);
+  u -= i;
+  v -= j;
+
+  const EnrichFactors& a = vals_[i * nt_ + j];
+  const EnrichFactors& b = vals_[i * nt_ + j + 1];
+  const EnrichFactors& c = vals_[(i + 1) * nt_ + j];
+  const EnrichFactors& d = vals_[(i + 1) * nt_ + j + 1];
+  EnrichFactors f;
+  f.swu = (1 - u) * ((1 - v) * a.swu + v * b.swu) +
+          u * ((1 - v) * c.swu + v * d.swu);
+  f.feed = (1 - u) * ((1 - v) * a.feed + v * b.feed) +
+           u * ((1 - v) * c.feed + v * d.feed);
+  return f;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Enrichment::Enrichment(cyclus::Context* ctx)
     : cyclus::Facility(ctx),
@@ -24,7 +149,21 @@ Enrichment::Enrichment(cyclus::Context* ctx)
       feed_recipe(""),
       product_commod(""),
       tails_commod(""),
-      order_prefs(true) {}
+      order_prefs(true),
+      coalesce_tails(false),
+      tails_tol(1e-6),
+      batch_enrich(false),
+      cascade_alpha(0),
+      optimize_tails(false),
+      tails_assay_min(0.001),
+      tails_assay_max(0.003),
+      feed_u235_(0),
+      feed_u_(0),
+      feed_qty_(0),
+      offer_time_(-1),
+      offer_feed_assay_(0),
+      offer_tails_assay_(0),
+      tails_x_(-1) {}
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Enrichment::~Enrichment() {}
@@ -53,7 +192,7 @@ void Enrichment::Build(cyclus::Agent* parent) {
       cyclus::CompMap comp;
       comp[922350000] = tails_assay;
       comp[922380000] = 1 - tails_assay;
-      tails.Push(Material::Create(this, initial_tails, cyclus::Composition::CreateFromAtom(comp)));
+      PushTails_(Material::Create(this, initial_tails, cyclus::Composition::CreateFromAtom(comp)));
     }
 
   LOG(cyclus::LEV_DEBUG2, "EnrFac") << "Enrichment "
@@ -64,11 +203,15 @@ void Enrichment::Build(cyclus::Agent* parent) {
 void Enrichment::EnterNotify() {
   cyclus::Facility::EnterNotify();
   InitializePosition();
+  if (optimize_tails) {
+    BuildTailsTable_(UAssay(context()->GetRecipe(feed_recipe)->mass()));
+  }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Enrichment::Tick() {
   current_swu_capacity = SwuCapacity();
+  tails_x_ = -1;
 
 }
 
@@ -103,17 +246,13 @@ Enrichment::GetMatlRequests() {
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-bool SortBids(cyclus::Bid<Material>* i,
-              cyclus::Bid<Material>* j) {
-  Material::Ptr mat_i = i->offer();
-  Material::Ptr mat_j = j->offer();
-
-  cyclus::toolkit::MatQuery mq_i(mat_i);
-  cyclus::toolkit::MatQuery mq_j(mat_j);
-
-  return ((mq_i.mass(922350000) / mq_i.qty()) <=
-          (mq_j.mass(922350000) / mq_j.qty()));
+// orders (U-235 mass fraction, bid) pairs by fraction only, so a stable sort
+// keeps equal-content bids in exchange order
+static bool SortBids(const std::pair<double, cyclus::Bid<Material>*>& i,
+                     const std::pair<double, cyclus::Bid<Material>*>& j) {
+  return i.first < j.first;
 }
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Sort offers of input material to have higher preference for more
 //  U-235 content
@@ -125,36 +264,35 @@ void Enrichment::AdjustMatlPrefs(
     return;
   }
 
+  // the same offers show up under every request, so look up each offer
+  // composition's U-235 mass fraction once for the whole exchange
+  std::map<int, double> u235_fracs;
+  std::vector<std::pair<double, Bid<Material>*> > bids_vector;
   cyclus::PrefMap<Material>::type::iterator reqit;
 
   // Loop over all requests
   for (reqit = prefs.begin(); reqit != prefs.end(); ++reqit) {
-    std::vector<Bid<Material>*> bids_vector;
+    bids_vector.clear();
     std::map<Bid<Material>*, double>::iterator mit;
     for (mit = reqit->second.begin(); mit != reqit->second.end(); ++mit) {
       Bid<Material>* bid = mit->first;
-      bids_vector.push_back(bid);
+      cyclus::Composition::Ptr c = bid->offer()->comp();
+      std::map<int, double>::iterator fit = u235_fracs.find(c->id());
+      if (fit == u235_fracs.end()) {
+        // recipes need not be normalized, so let MatQuery take the fraction
+        cyclus::toolkit::MatQuery mq(bid->offer());
+        double frac = mq.mass_frac(922350000);
+        fit = u235_fracs.insert(std::make_pair(c->id(), frac)).first;
+      }
+      bids_vector.push_back(std::make_pair(fit->second, bid));
     }
-    std::sort(bids_vector.begin(), bids_vector.end(), SortBids);
+    std::stable_sort(bids_vector.begin(), bids_vector.end(), SortBids);
 
     // Assign preferences to the sorted vector
-    double n_bids = bids_vector.size();
-    bool u235_mass = 0;
-
     for (int bidit = 0; bidit < bids_vector.size(); bidit++) {
-      int new_pref = bidit + 1;
-
       // For any bids with U-235 qty=0, set pref to zero.
-      if (!u235_mass) {
-        Material::Ptr mat = bids_vector[bidit]->offer();
-        cyclus::toolkit::MatQuery mq(mat);
-        if (mq.mass(922350000) == 0) {
-          new_pref = -1;
-        } else {
-          u235_mass = true;
-        }
-      }
-      (reqit->second)[bids_vector[bidit]] = new_pref;
+      int new_pref = bids_vector[bidit].first > 0 ? bidit + 1 : -1;
+      (reqit->second)[bids_vector[bidit].second] = new_pref;
     }  // each bid
   }    // each Material Request
 }
@@ -191,12 +329,12 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Enrichment::GetMatlBids(
 
     std::vector<Request<Material>*>& tails_requests =
         out_requests[tails_commod];
+    // offer bids for all tails material, keeping discrete quantities
+    // to preserve possible variation in composition
+    MatVec mats = tails.PopN(tails.count());
+    tails.Push(mats);
     std::vector<Request<Material>*>::iterator it;
     for (it = tails_requests.begin(); it != tails_requests.end(); ++it) {
-      // offer bids for all tails material, keeping discrete quantities
-      // to preserve possible variation in composition
-      MatVec mats = tails.PopN(tails.count());
-      tails.Push(mats);
       for (int k = 0; k < mats.size(); k++) {
         Material::Ptr m = mats[k];
         Request<Material>* req = *it;
@@ -207,9 +345,9 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Enrichment::GetMatlBids(
     // add an overall capacity constraint
     CapacityConstraint<Material> tails_constraint(tails.quantity());
     tails_port->AddConstraint(tails_constraint);
-    LOG(cyclus::LEV_INFO5, "EnrFac") << prototype()
-                                     << " adding tails capacity constraint of "
-                                     << tails.capacity();
+    CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+        << prototype() << " adding tails capacity constraint of "
+        << tails.capacity();
     ports.insert(tails_port);
   }
 
@@ -218,11 +356,12 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Enrichment::GetMatlBids(
 
     std::vector<Request<Material>*>& commod_requests =
         out_requests[product_commod];
+    SelectTails_(commod_requests);
     std::vector<Request<Material>*>::iterator it;
     for (it = commod_requests.begin(); it != commod_requests.end(); ++it) {
       Request<Material>* req = *it;
       Material::Ptr mat = req->target();
-      double request_enrich = cyclus::toolkit::UraniumAssayMass(mat);
+      double request_enrich = UAssay(mat->comp()->mass());
       if (ValidReq(req->target()) &&
           ((request_enrich < max_enrich) ||
            (cyclus::AlmostEq(request_enrich, max_enrich)))) {
@@ -231,28 +370,118 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Enrichment::GetMatlBids(
       }
     }
 
-    Converter<Material>::Ptr sc(new SWUConverter(FeedAssay(), tails_assay));
-    Converter<Material>::Ptr nc(new NatUConverter(FeedAssay(), tails_assay));
+    double feed_assay = FeedAssay();
+    Converter<Material>::Ptr sc(new SWUConverter(
+        feed_assay, TailsAssay_(), &offer_factors_, &cascade()));
+    Converter<Material>::Ptr nc(new NatUConverter(
+        feed_assay, TailsAssay_(), &offer_factors_, &cascade()));
     CapacityConstraint<Material> swu(swu_capacity, sc);
     CapacityConstraint<Material> natu(inventory.quantity(), nc);
     commod_port->AddConstraint(swu);
     commod_port->AddConstraint(natu);
 
-    LOG(cyclus::LEV_INFO5, "EnrFac")
+    CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
         << prototype() << " adding a swu constraint of " << swu.capacity();
-    LOG(cyclus::LEV_INFO5, "EnrFac")
+    CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
         << prototype() << " adding a natu constraint of " << natu.capacity();
     ports.insert(commod_port);
   }
   return ports;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double Enrichment::TailsAssay_() const {
+  return optimize_tails && tails_x_ >= 0 ? tails_x_ : tails_assay;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Enrichment::BuildTailsTable_(double feed_assay) {
+  // product grid from the feed assay to the enrichment limit (short of pure
+  // U-235, where the value function diverges); tails must stay below feed
+  double p_hi = std::min(max_enrich, 1 - 1e-6);
+  double t_hi = std::min(tails_assay_max, feed_assay * (1 - 1e-6));
+  if (feed_assay <= 0 || t_hi < tails_assay_min || p_hi <= feed_assay) {
+    tails_table_ = EnrichTable();
+    return;
+  }
+  tails_table_.Build(cascade(), feed_assay, feed_assay, p_hi,
+                     kTableProducts, tails_assay_min, t_hi, kTableTails);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Enrichment::SelectTails_(
+    const std::vector<cyclus::Request<Material>*>& requests) {
+  tails_x_ = -1;
+  if (!optimize_tails || requests.empty() || inventory.empty()) {
+    return;
+  }
+  double feed_assay = FeedAssay();
+  if (tails_table_.empty() ||
+      !cyclus::AlmostEq(tails_table_.feed(), feed_assay, 1e-9)) {
+    BuildTailsTable_(feed_assay);
+  }
+  if (tails_table_.empty()) {
+    return;
+  }
+
+  // requested product by assay; only these can be enriched from this feed
+  std::map<double, double> demand;
+  for (int i = 0; i < requests.size(); ++i) {
+    Material::Ptr mat = requests[i]->target();
+    double x = UAssay(mat->comp()->mass());
+    if (x > feed_assay && (x < max_enrich || cyclus::AlmostEq(x, max_enrich))) {
+      demand[x] += mat->quantity();
+    }
+  }
+  if (demand.empty()) {
+    return;
+  }
+
+  // pick the tails assay that serves the largest fraction of demand with
+  // the SWU and feed on hand; among equals, the one using the least feed
+  double natu_frac = FeedUFrac_();
+  if (natu_frac <= 0) {
+    return;  // no uranium in the feed
+  }
+  double feed_inv = inventory.quantity();
+  double best_frac = -1;
+  double best_feed = 0;
+  for (int j = 0; j < tails_table_.ntails(); ++j) {
+    double x_t = tails_table_.tails(j);
+    double swu = 0;
+    double feed = 0;
+    std::map<double, double>::iterator it;
+    for (it = demand.begin(); it != demand.end(); ++it) {
+      EnrichFactors f = tails_table_.Lookup(it->first, x_t);
+      swu += it->second * f.swu;
+      feed += it->second * f.feed / natu_frac;
+    }
+    double frac = 1;
+    if (swu > current_swu_capacity) {
+      frac = current_swu_capacity / swu;
+    }
+    if (feed > feed_inv) {
+      frac = std::min(frac, feed_inv / feed);
+    }
+    if (frac > best_frac + 1e-9 ||
+        (frac > best_frac - 1e-9 && feed < best_feed)) {
+      best_frac = std::max(frac, best_frac);
+      best_feed = feed;
+      tails_x_ = x_t;
+    }
+  }
+
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+      << prototype() << " selected a tails assay of " << tails_x_ * 100
+      << " to serve " << best_frac * 100 << "% of requested product";
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 bool Enrichment::ValidReq(const Material::Ptr mat) {
   cyclus::toolkit::MatQuery q(mat);
   double u235 = q.atom_frac(922350000);
   double u238 = q.atom_frac(922380000);
-  return (u238 > 0 && u235 / (u235 + u238) > tails_assay);
+  return (u238 > 0 && u235 / (u235 + u238) > TailsAssay_());
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -265,6 +494,7 @@ void Enrichment::GetMatlTrades(
   intra_timestep_swu_ = 0;
   intra_timestep_feed_ = 0;
 
+  std::vector<Trade<Material> > product_trades;
   std::vector<Trade<Material>>::const_iterator it;
   for (it = trades.begin(); it != trades.end(); ++it) {
     double qty = it->amt;
@@ -272,20 +502,26 @@ void Enrichment::GetMatlTrades(
     Material::Ptr response;
     // Figure out whether material is tails or enriched,
     // if tails then make transfer of material
-    if (commod_type == tails_commod) {
-      LOG(cyclus::LEV_INFO5, "EnrFac")
+    if (commod_type != tails_commod && batch_enrich) {
+      product_trades.push_back(*it);
+      continue;
+    } else if (commod_type == tails_commod) {
+      CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
           << prototype() << " just received an order"
           << " for " << it->amt << " of " << tails_commod;
       double pop_qty = std::min(qty, tails.quantity());
       response = tails.Pop(pop_qty, cyclus::eps_rsrc());
     } else {
-      LOG(cyclus::LEV_INFO5, "EnrFac")
+      CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
           << prototype() << " just received an order"
           << " for " << it->amt << " of " << product_commod;
       response = Enrich_(it->bid->offer(), qty);
     }
     responses.push_back(std::make_pair(*it, response));
   }
+  if (!product_trades.empty()) {
+    EnrichBatch_(product_trades, responses);
+  }
 
   if (cyclus::IsNegative(tails.quantity())) {
     std::stringstream ss;
@@ -326,17 +562,20 @@ void Enrichment::AddMat_(Material::Ptr mat) {
         "sent directly to tails.");
   }
 
-  LOG(cyclus::LEV_INFO5, "EnrFac") << prototype() << " is initially holding "
-                                   << inventory.quantity() << " total.";
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+      << prototype() << " is initially holding " << inventory.quantity()
+      << " total.";
 
+  SyncFeed_();
   try {
     inventory.Push(mat);
   } catch (cyclus::Error& e) {
     e.msg(Agent::InformErrorMsg(e.msg()));
     throw e;
   }
+  TallyFeed_(mat, 1);
 
-  LOG(cyclus::LEV_INFO5, "EnrFac")
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
       << prototype() << " added " << mat->quantity() << " of " << feed_commod
       << " to its inventory, which is holding " << inventory.quantity()
       << " total.";
@@ -351,13 +590,39 @@ Material::Ptr Enrichment::Request_() {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Material::Ptr Enrichment::Offer_(Material::Ptr mat) {
-  cyclus::toolkit::MatQuery q(mat);
+  using cyclus::Composition;
+
+  double feed_assay = FeedAssay();
+  if (offer_time_ != context()->time() || offer_feed_assay_ != feed_assay ||
+      offer_tails_assay_ != TailsAssay_()) {
+    offer_comps_.clear();
+    offer_factors_.clear();
+    offer_time_ = context()->time();
+    offer_feed_assay_ = feed_assay;
+    offer_tails_assay_ = TailsAssay_();
+  }
+
+  const cyclus::CompMap& atoms = mat->comp()->atom();
+  double assay = UAssay(atoms);
+  std::map<double, Composition::Ptr>::iterator it = offer_comps_.find(assay);
+  if (it != offer_comps_.end()) {
+    return Material::CreateUntracked(mat->quantity(), it->second);
+  }
+
   cyclus::CompMap comp;
-  comp[922350000] = q.atom_frac(922350000);
-  comp[922380000] = q.atom_frac(922380000);
-  return Material::CreateUntracked(
-      mat->quantity(), cyclus::Composition::CreateFromAtom(comp));
+  cyclus::CompMap::const_iterator nuc = atoms.find(922350000);
+  comp[922350000] = nuc != atoms.end() ? nuc->second : 0;
+  nuc = atoms.find(922380000);
+  comp[922380000] = nuc != atoms.end() ? nuc->second : 0;
+  Composition::Ptr c = Composition::CreateFromAtom(comp);
+  offer_comps_[assay] = c;
+
+  // offers are pure uranium, so the feed factor needs no natu_frac correction
+  offer_factors_[c->id()] = Factors_(feed_assay, UAssay(c->mass()));
+
+  return Material::CreateUntracked(mat->quantity(), c);
 }
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Material::Ptr Enrichment::Enrich_(Material::Ptr mat,
                                           double qty) {
@@ -368,34 +633,29 @@ Material::Ptr Enrichment::Enrich_(Material::Ptr mat,
   using cyclus::toolkit::TailsQty;
 
   // get enrichment parameters
-  Assays assays(FeedAssay(), UraniumAssayMass(mat), tails_assay);
+  Assays assays(FeedAssay(), UraniumAssayMass(mat), TailsAssay_());
   double swu_req = SwuRequired(qty, assays);
   double natu_req = FeedQty(qty, assays);
+  double tails_x = assays.Tails();
+  if (cascade().enabled()) {
+    const Cascade::Solution& s =
+        cascade().Solve(assays.Feed(), assays.Product(), assays.Tails());
+    swu_req = qty * s.swu;
+    natu_req = qty * s.feed;
+    tails_x = s.tails;
+  }
 
   // Determine the composition of the natural uranium
   // (ie. U-235+U-238/TotalMass)
-  double pop_qty = inventory.quantity();
-  Material::Ptr natu_matl = inventory.Pop(pop_qty, cyclus::eps_rsrc());
-  inventory.Push(natu_matl);
-
-  cyclus::toolkit::MatQuery mq(natu_matl);
-  std::set<cyclus::Nuc> nucs;
-  nucs.insert(922350000);
-  nucs.insert(922380000);
-  double natu_frac = mq.mass_frac(nucs);
+  double natu_frac = FeedUFrac_();
   double feed_req = natu_req / natu_frac;
 
   // pop amount from inventory and blob it into one material
   Material::Ptr r;
   try {
-    // required so popping doesn't take out too much
-    if (cyclus::AlmostEq(feed_req, inventory.quantity())) {
-      r = cyclus::toolkit::Squash(inventory.PopN(inventory.count()));
-    } else {
-      r = inventory.Pop(feed_req, cyclus::eps_rsrc());
-    }
+    r = PopFeed_(feed_req);
   } catch (cyclus::Error& e) {
-    NatUConverter nc(FeedAssay(), tails_assay);
+    NatUConverter nc(FeedAssay(), TailsAssay_(), NULL, &cascade());
     std::stringstream ss;
     ss << " tried to remove " << feed_req << " from its inventory of size "
        << inventory.quantity()
@@ -408,7 +668,7 @@ Material::Ptr Enrichment::Enrich_(Material::Ptr mat,
   // blob
   cyclus::Composition::Ptr comp = mat->comp();
   Material::Ptr response = r->ExtractComp(qty, comp);
-  tails.Push(r);
+  PushTails_(r);
 
   current_swu_capacity -= swu_req;
 
@@ -416,34 +676,140 @@ Material::Ptr Enrichment::Enrich_(Material::Ptr mat,
   intra_timestep_feed_ += feed_req;
   RecordEnrichment_(feed_req, swu_req);
 
-  LOG(cyclus::LEV_INFO5, "EnrFac") << prototype()
-                                   << " has performed an enrichment: ";
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Feed Qty: " << feed_req;
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Feed Assay: "
-                                   << assays.Feed() * 100;
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Product Qty: " << qty;
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Product Assay: "
-                                   << assays.Product() * 100;
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Tails Qty: "
-                                   << TailsQty(qty, assays);
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Tails Assay: "
-                                   << assays.Tails() * 100;
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * SWU: " << swu_req;
-  LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Current SWU capacity: "
-                                   << current_swu_capacity;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+      << prototype() << " has performed an enrichment: ";
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Feed Qty: " << feed_req;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Feed Assay: "
+                                            << assays.Feed() * 100;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Product Qty: " << qty;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Product Assay: "
+                                            << assays.Product() * 100;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+      << "   * Tails Qty: "
+      << (cascade().enabled() ? natu_req - qty : TailsQty(qty, assays));
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Tails Assay: "
+                                            << tails_x * 100;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * SWU: " << swu_req;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << "   * Current SWU capacity: "
+                                            << current_swu_capacity;
 
   return response;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Enrichment::EnrichBatch_(
+    const std::vector<cyclus::Trade<Material> >& trades,
+    std::vector<std::pair<cyclus::Trade<Material>,
+                          Material::Ptr> >& responses) {
+  // group trades by product assay; SWU and feed are linear in product
+  // quantity, so each group needs a single evaluation
+  std::map<double, std::vector<int> > groups;
+  for (int i = 0; i < trades.size(); ++i) {
+    groups[UAssay(trades[i].bid->offer()->comp()->mass())].push_back(i);
+  }
+
+  double feed_assay = FeedAssay();
+  double natu_frac = FeedUFrac_();
+  std::map<double, std::vector<int> >::iterator g;
+  std::map<double, std::pair<double, double> > totals;  // assay -> feed, swu
+  double prod_qty = 0;
+  double feed_req = 0;
+  for (g = groups.begin(); g != groups.end(); ++g) {
+    double qty = 0;
+    for (int k = 0; k < g->second.size(); ++k) {
+      qty += trades[g->second[k]].amt;
+    }
+    EnrichFactors f = Factors_(feed_assay, g->first);
+    double feed = qty * f.feed / natu_frac;
+    totals[g->first] = std::make_pair(feed, qty * f.swu);
+    prod_qty += qty;
+    feed_req += feed;
+  }
+
+  Material::Ptr r;
+  try {
+    r = PopFeed_(feed_req);
+  } catch (cyclus::Error& e) {
+    std::stringstream ss;
+    ss << " tried to remove " << feed_req << " from its inventory of size "
+       << inventory.quantity() << " to fill " << trades.size()
+       << " product trades";
+    throw cyclus::ValueError(Agent::InformErrorMsg(ss.str()));
+  }
+
+  for (g = groups.begin(); g != groups.end(); ++g) {
+    for (int k = 0; k < g->second.size(); ++k) {
+      const cyclus::Trade<Material>& t = trades[g->second[k]];
+      Material::Ptr response = r->ExtractComp(t.amt, t.bid->offer()->comp());
+      responses.push_back(std::make_pair(t, response));
+    }
+
+    double feed = totals[g->first].first;
+    double swu = totals[g->first].second;
+    current_swu_capacity -= swu;
+    intra_timestep_swu_ += swu;
+    intra_timestep_feed_ += feed;
+    RecordEnrichment_(feed, swu);
+
+    CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+        << prototype() << " has performed a batched enrichment: "
+        << g->second.size() << " trades at product assay " << g->first * 100
+        << " using " << feed << " feed and " << swu << " SWU";
+  }
+  PushTails_(r);
+
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac")
+      << prototype() << " batch used " << feed_req << " feed (assay "
+      << feed_assay * 100 << ") for " << prod_qty << " product; "
+      << "current SWU capacity: " << current_swu_capacity;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+EnrichFactors Enrichment::Factors_(double feed_assay, double product_assay) {
+  EnrichFactors f;
+  if (cascade().enabled()) {
+    const Cascade::Solution& s =
+        cascade().Solve(feed_assay, product_assay, TailsAssay_());
+    f.swu = s.swu;
+    f.feed = s.feed;
+  } else {
+    cyclus::toolkit::Assays assays(feed_assay, product_assay, TailsAssay_());
+    f.swu = cyclus::toolkit::SwuRequired(1, assays);
+    f.feed = cyclus::toolkit::FeedQty(1, assays);
+  }
+  return f;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const Cascade& Enrichment::cascade() {
+  if (cascade_.alpha() != cascade_alpha) {
+    cascade_ = Cascade(cascade_alpha);
+  }
+  return cascade_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Material::Ptr Enrichment::PopFeed_(double feed_req) {
+  Material::Ptr r;
+  // required so popping doesn't take out too much
+  if (cyclus::AlmostEq(feed_req, inventory.quantity())) {
+    r = cyclus::toolkit::Squash(inventory.PopN(inventory.count()));
+  } else {
+    r = inventory.Pop(feed_req, cyclus::eps_rsrc());
+  }
+  TallyFeed_(r, -1);
+  return r;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Enrichment::RecordEnrichment_(double natural_u, double swu) {
   using cyclus::Context;
   using cyclus::Agent;
 
-  LOG(cyclus::LEV_DEBUG1, "EnrFac") << prototype()
-                                    << " has enriched a material:";
-  LOG(cyclus::LEV_DEBUG1, "EnrFac") << "  * Amount: " << natural_u;
-  LOG(cyclus::LEV_DEBUG1, "EnrFac") << "  *    SWU: " << swu;
+  CYCAMORE_LOG(cyclus::LEV_DEBUG1, "EnrFac") << prototype()
+                                             << " has enriched a material:";
+  CYCAMORE_LOG(cyclus::LEV_DEBUG1, "EnrFac") << "  * Amount: " << natural_u;
+  CYCAMORE_LOG(cyclus::LEV_DEBUG1, "EnrFac") << "  *    SWU: " << swu;
 
   Context* ctx = Agent::context();
   ctx->NewDatum("Enrichments")
@@ -453,16 +819,76 @@ void Enrichment::RecordEnrichment_(double natural_u, double swu) {
       ->AddVal("SWU", swu)
       ->Record();
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Enrichment::PushTails_(Material::Ptr mat) {
+  if (!coalesce_tails || tails.empty()) {
+    tails.Push(mat);
+    return;
+  }
+
+  // a coalesced buffer holds one entry per distinct composition, so scanning
+  // it whole is cheap; entries are popped because absorbing in place would
+  // leave the buffer's quantity stale
+  cyclus::toolkit::MatVec mats = tails.PopN(tails.count());
+  bool merged = false;
+  for (int i = 0; i < mats.size() && !merged; ++i) {
+    if (mats[i]->comp() == mat->comp() ||
+        cyclus::compmath::AlmostEq(mats[i]->comp()->mass(),
+                                   mat->comp()->mass(), tails_tol)) {
+      mats[i]->Absorb(mat);
+      merged = true;
+    }
+  }
+  tails.Push(mats);
+  if (!merged) {
+    tails.Push(mat);
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 double Enrichment::FeedAssay() {
   if (inventory.empty()) {
     return 0;
   }
-  double pop_qty = inventory.quantity();
-  Material::Ptr fission_matl =
-      inventory.Pop(pop_qty, cyclus::eps_rsrc());
-  inventory.Push(fission_matl);
-  return cyclus::toolkit::UraniumAssayMass(fission_matl);
+  SyncFeed_();
+  return feed_u_ > 0 ? feed_u235_ / feed_u_ : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double Enrichment::FeedUFrac_() {
+  if (inventory.empty()) {
+    return 0;
+  }
+  SyncFeed_();
+  return feed_u_ / feed_qty_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Enrichment::TallyFeed_(Material::Ptr mat, double sign) {
+  cyclus::toolkit::MatQuery mq(mat);
+  double u235 = mq.mass(922350000);
+  feed_u235_ += sign * u235;
+  feed_u_ += sign * (u235 + mq.mass(922380000));
+  feed_qty_ += sign * mat->quantity();
+  if (inventory.empty()) {
+    // don't let round-off accumulate across refills
+    feed_u235_ = feed_u_ = feed_qty_ = 0;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Enrichment::SyncFeed_() {
+  if (cyclus::AlmostEq(feed_qty_, inventory.quantity(), cyclus::eps_rsrc())) {
+    return;
+  }
+  // discrete materials are popped and pushed back whole, so this neither
+  // squashes the inventory nor creates new resource records
+  feed_u235_ = feed_u_ = feed_qty_ = 0;
+  cyclus::toolkit::MatVec mats = inventory.PopN(inventory.count());
+  inventory.Push(mats);
+  for (int i = 0; i < mats.size(); ++i) {
+    TallyFeed_(mats[i], 1);
+  }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1,7 +1,9 @@
 #ifndef CYCAMORE_SRC_ENRICHMENT_H_
 #define CYCAMORE_SRC_ENRICHMENT_H_
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "cyclus.h"
 #include "cycamore_version.h"
@@ -10,14 +12,130 @@
 
 namespace cycamore {
 
+/// @brief SWU and natural uranium feed required per kg of product for one
+/// product composition at a fixed feed and tails assay
+struct EnrichFactors {
+  double swu;
+  double feed;
+};
+
+/// enrichment factors keyed by product composition id
+typedef std::map<int, EnrichFactors> EnrichFactorMap;
+
+/// @class Cascade
+///
+/// @brief A symmetric countercurrent cascade of identical stages with a
+/// heads-to-tails separation factor alpha, so that each stage multiplies the
+/// U-235 abundance ratio by beta = sqrt(alpha). The numbers of enriching and
+/// stripping stages needed to reach the requested product and tails assays
+/// are rounded up to whole stages, and the product overshoot is blended back
+/// down with feed. Solutions are memoized per (feed, product, tails) assay.
+/// Feed assays drift with the inventory, so the memo holds at most capacity
+/// solutions and drops the least recently used one to make room.
+class Cascade {
+ public:
+  /// @brief a cascade solution, per kg of (blended) product
+  struct Solution {
+    double swu;  ///< separative work
+    double feed;  ///< uranium feed, including feed used for blending
+    double product;  ///< assay leaving the top of the cascade
+    double tails;  ///< assay leaving the bottom of the cascade
+    int enriching;  ///< number of enriching stages
+    int stripping;  ///< number of stripping stages
+  };
+
+  enum { kDefaultCapacity = 1024 };
+
+  /// @param alpha the stage separation factor, values <= 1 disable the model
+  /// @param capacity the maximum number of memoized solutions
+  explicit Cascade(double alpha = 0, int capacity = kDefaultCapacity)
+      : alpha_(alpha), capacity_(capacity), uses_(0) {}
+
+  inline double alpha() const { return alpha_; }
+
+  /// @returns true if the cascade model is in use
+  inline bool enabled() const { return alpha_ > 1; }
+
+  /// @brief solves the cascade for the given mass assays, or returns the
+  /// memoized solution. Requests that need no enriching or stripping (or a
+  /// disabled model) get the ideal SwuRequired/FeedQty values. The returned
+  /// reference is valid until the solution is dropped from the memo.
+  const Solution& Solve(double feed, double product, double tails) const;
+
+  /// @brief solves the cascade as Solve does, without memoizing the result
+  Solution Compute(double feed, double product, double tails) const;
+
+  /// @returns the number of memoized solutions
+  inline int size() const { return solutions_.size(); }
+
+  /// @returns the maximum number of memoized solutions
+  inline int capacity() const { return capacity_; }
+
+ private:
+  typedef std::pair<double, std::pair<double, double> > Key;
+
+  /// a memoized solution and the use count at its last lookup
+  struct Entry {
+    Solution solution;
+    long last_use;
+  };
+
+  double alpha_;
+  int capacity_;
+  mutable long uses_;
+  mutable std::map<Key, Entry> solutions_;
+  // memoized keys by last use, least recently used first
+  mutable std::map<long, Key> by_use_;
+};
+
+/// @class EnrichTable
+///
+/// @brief SWU and uranium feed per kg of product tabulated on a uniform
+/// (product assay, tails assay) grid at one feed assay, and bilinearly
+/// interpolated between grid points. Lookups outside the grid are clamped.
+class EnrichTable {
+ public:
+  EnrichTable() : feed_(0), np_(0), nt_(0) {}
+
+  /// @brief tabulates the cascade (or ideal) solution for the feed assay
+  /// over np product assays in [p_lo, p_hi] and nt tails assays in
+  /// [t_lo, t_hi]
+  void Build(const Cascade& cascade, double feed, double p_lo, double p_hi,
+             int np, double t_lo, double t_hi, int nt);
+
+  /// @returns the interpolated factors at the given product and tails assay
+  EnrichFactors Lookup(double product, double tails) const;
+
+  inline bool empty() const { return vals_.empty(); }
+  inline double feed() const { return feed_; }
+
+  /// @returns the number of tails assays on the grid
+  inline int ntails() const { return nt_; }
+
+  /// @returns the i-th tails assay on the grid
+  inline double tails(int i) const { return t_lo_ + i * dt_; }
+
+ private:
+  double feed_;
+  double p_lo_, dp_, t_lo_, dt_;
+  int np_, nt_;
+  std::vector<EnrichFactors> vals_;  // product-major
+};
+
 /// @class SWUConverter
 ///
 /// @brief The SWUConverter is a simple Converter class for material to
 /// determine the amount of SWU required for their proposed enrichment
 class SWUConverter : public cyclus::Converter<cyclus::Material> {
  public:
-  SWUConverter(double feed_commod, double tails) : feed_(feed_commod),
-    tails_(tails) {}
+  /// @param factors optional precomputed factors (computed with the same feed
+  /// and tails assay) looked up by the converted material's composition
+  /// @param cascade optional cascade model used instead of the ideal formulas
+  /// when enabled
+  SWUConverter(double feed_commod, double tails,
+               const EnrichFactorMap* factors = NULL,
+               const Cascade* cascade = NULL) : feed_(feed_commod),
+    tails_(tails), factors_(factors), cascade_(cascade) {}
   virtual ~SWUConverter() {}
 
   /// @brief provides a conversion for the SWU required
@@ -26,6 +144,16 @@ class SWUConverter : public cyclus::Converter<cyclus::Material> {
       cyclus::Arc const * a = NULL,
       cyclus::ExchangeTranslationContext<cyclus::Material>
           const * ctx = NULL) const {
+    if (factors_ != NULL) {
+      EnrichFactorMap::const_iterator it = factors_->find(m->comp()->id());
+      if (it != factors_->end()) {
+        return m->quantity() * it->second.swu;
+      }
+    }
+    if (cascade_ != NULL && cascade_->enabled()) {
+      return m->quantity() * cascade_->Solve(
+          feed_, cyclus::toolkit::UraniumAssayMass(m), tails_).swu;
+    }
     cyclus::toolkit::Assays assays(feed_, cyclus::toolkit::UraniumAssayMass(m),
                                    tails_);
     return cyclus::toolkit::SwuRequired(m->quantity(), assays);
@@ -36,11 +164,15 @@ class SWUConverter : public cyclus::Converter<cyclus::Material> {
     SWUConverter* cast = dynamic_cast<SWUConverter*>(&other);
     return cast != NULL &&
     feed_ == cast->feed_ &&
-    tails_ == cast->tails_;
+    tails_ == cast->tails_ &&
+    factors_ == cast->factors_ &&
+    cascade_ == cast->cascade_;
   }
 
  private:
   double feed_, tails_;
+  const EnrichFactorMap* factors_;
+  const Cascade* cascade_;
 };
 
 /// @class NatUConverter
@@ -50,8 +182,14 @@ class SWUConverter : public cyclus::Converter<cyclus::Material> {
 /// enrichment
 class NatUConverter : public cyclus::Converter<cyclus::Material> {
  public:
-  NatUConverter(double feed_commod, double tails) : feed_(feed_commod),
-    tails_(tails) {}
+  /// @param factors optional precomputed factors (computed with the same feed
+  /// and tails assay) looked up by the converted material's composition
+  /// @param cascade optional cascade model used instead of the ideal formulas
+  /// when enabled
+  NatUConverter(double feed_commod, double tails,
+                const EnrichFactorMap* factors = NULL,
+                const Cascade* cascade = NULL) : feed_(feed_commod),
+    tails_(tails), factors_(factors), cascade_(cascade) {}
   virtual ~NatUConverter() {}
 
   virtual std::string version() { return CYCAMORE_VERSION; }
@@ -62,6 +200,12 @@ class NatUConverter : public cyclus::Converter<cyclus::Material> {
       cyclus::Arc const * a = NULL,
       cyclus::ExchangeTranslationContext<cyclus::Material>
           const * ctx = NULL) const {
+    if (factors_ != NULL) {
+      EnrichFactorMap::const_iterator it = factors_->find(m->comp()->id());
+      if (it != factors_->end()) {
+        return m->quantity() * it->second.feed;
+      }
+    }
     cyclus::toolkit::Assays assays(feed_, cyclus::toolkit::UraniumAssayMass(m),
                                    tails_);
     cyclus::toolkit::MatQuery mq(m);
@@ -70,7 +214,13 @@ class NatUConverter : public cyclus::Converter<cyclus::Material> {
     nucs.insert(922380000);
 
     double natu_frac = mq.mass_frac(nucs);
-    double natu_req = cyclus::toolkit::FeedQty(m->quantity(), assays);
+    double natu_req;
+    if (cascade_ != NULL && cascade_->enabled()) {
+      natu_req = m->quantity() * cascade_->Solve(
+          feed_, assays.Product(), tails_).feed;
+    } else {
+      natu_req = cyclus::toolkit::FeedQty(m->quantity(), assays);
+    }
     return natu_req / natu_frac;
   }
 
@@ -79,11 +229,15 @@ class NatUConverter : public cyclus::Converter<cyclus::Material> {
     NatUConverter* cast = dynamic_cast<NatUConverter*>(&other);
     return cast != NULL &&
     feed_ == cast->feed_ &&
-    tails_ == cast->tails_;
+    tails_ == cast->tails_ &&
+    factors_ == cast->factors_ &&
+    cascade_ == cast->cascade_;
   }
 
  private:
   double feed_, tails_;
+  const EnrichFactorMap* factors_;
+  const Cascade* cascade_;
 };
 
 ///  The Enrichment facility is a simple Agent that enriches natural
@@ -264,19 +418,68 @@ class Enrichment
   ///  @brief Generates a material offer for a given request. The response
   ///  composition will be comprised only of U235 and U238 at their relative
   ///  ratio in the requested material. The response quantity will be the
-  ///  same as the requested commodity.
+  ///  same as the requested commodity. Offer compositions and their
+  ///  enrichment factors are cached per time step by product assay.
   ///
   ///  @param req the requested material being responded to
   cyclus::Material::Ptr Offer_(cyclus::Material::Ptr req);
 
   cyclus::Material::Ptr Enrich_(cyclus::Material::Ptr mat, double qty);
 
+  ///  @brief fills all product trades of a time step from a single pop of
+  ///  feed, recording one enrichment per product assay (see batch_enrich)
+  ///
+  ///  @param trades the product trades to fill
+  ///  @param responses a container to populate with responses to each trade
+  void EnrichBatch_(
+      const std::vector<cyclus::Trade<cyclus::Material> >& trades,
+      std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                            cyclus::Material::Ptr> >& responses);
+
+  ///  @brief pops feed_req of feed from the inventory as one material
+  cyclus::Material::Ptr PopFeed_(double feed_req);
+
+  ///  @brief SWU and uranium feed per kg of product at the given feed and
+  ///  product assays, from the cascade model when it is enabled
+  EnrichFactors Factors_(double feed_assay, double product_assay);
+
+  ///  @brief the cascade model for cascade_alpha
+  const Cascade& cascade();
+
+  ///  @brief the tails assay in effect: the one selected for this time step
+  ///  when optimize_tails is on, tails_assay otherwise
+  double TailsAssay_() const;
+
+  ///  @brief tabulates SWU and feed per kg of product over product assays up
+  ///  to max_enrich and tails assays in [tails_assay_min, tails_assay_max]
+  void BuildTailsTable_(double feed_assay);
+
+  ///  @brief selects this time step's tails assay for the given product
+  ///  requests (see optimize_tails)
+  void SelectTails_(
+      const std::vector<cyclus::Request<cyclus::Material>*>& requests);
+
   ///  @brief calculates the feed assay based on the unenriched inventory
   double FeedAssay();
 
+  ///  @brief the mass fraction of U-235 + U-238 in the unenriched inventory
+  double FeedUFrac_();
+
+  ///  @brief adds (sign = 1) or removes (sign = -1) a material's U-235, U
+  ///  and total mass from the running feed tallies
+  void TallyFeed_(cyclus::Material::Ptr mat, double sign);
+
+  ///  @brief rebuilds the feed tallies from the inventory if they no longer
+  ///  account for its full quantity (e.g. after a restart or a direct push)
+  void SyncFeed_();
+
   ///  @brief records and enrichment with the cyclus::Recorder
   void RecordEnrichment_(double natural_u, double swu);
 
+  ///  @brief adds a material to the tails buffer, merging it into an
+  ///  existing entry of the same composition when coalesce_tails is on
+  void PushTails_(cyclus::Material::Ptr mat);
+
   #pragma cyclus var { \
     "tooltip": "feed commodity",					\
     "doc": "feed commodity that the enrichment facility accepts",	\
@@ -372,6 +575,91 @@ class Enrichment
   }
   bool order_prefs;
 
+  #pragma cyclus var { \
+    "default": 0, \
+    "userlevel": 10, \
+    "tooltip": "Merge tails of the same composition", \
+    "uilabel": "Coalesce tails", \
+    "doc": "if true, tails from each enrichment are merged into an existing " \
+           "tails entry whose composition matches within tails_tol instead " \
+           "of being stored as a separate material, so the tails buffer " \
+           "and its bids scale with the number of distinct compositions" \
+  }
+  bool coalesce_tails;
+
+  #pragma cyclus var { \
+    "default": 1e-6, \
+    "userlevel": 10, \
+    "tooltip": "tails composition tolerance", \
+    "uilabel": "Tails coalescing tolerance", \
+    "doc": "largest per-nuclide difference in normalized mass fraction for " \
+           "two tails compositions to be merged when coalesce_tails is on" \
+  }
+  double tails_tol;
+
+  #pragma cyclus var { \
+    "default": 0, \
+    "userlevel": 10, \
+    "tooltip": "Fill product trades in one batch", \
+    "uilabel": "Batch enrichment", \
+    "doc": "if true, all product trades of a time step are filled from a " \
+           "single pop of feed, and one enrichment is recorded per product " \
+           "assay rather than per trade. The feed assay is taken once for " \
+           "the whole batch." \
+  }
+  bool batch_enrich;
+
+  #pragma cyclus var { \
+    "default": 0, \
+    "userlevel": 10, \
+    "tooltip": "cascade stage separation factor", \
+    "uilabel": "Cascade Stage Separation Factor", \
+    "doc": "if greater than 1, SWU and feed are computed for a symmetric " \
+           "cascade of whole enriching and stripping stages, each with this " \
+           "heads-to-tails separation factor (alpha), rather than from the " \
+           "ideal formulas. Product overshoot from rounding up the stage " \
+           "count is blended down with feed. The default (0) uses the " \
+           "ideal formulas." \
+  }
+  double cascade_alpha;
+
+  #pragma cyclus var { \
+    "default": 0, \
+    "userlevel": 10, \
+    "tooltip": "Choose the tails assay each time step", \
+    "uilabel": "Optimize tails assay", \
+    "doc": "if true, each time step the facility bids with the tails assay " \
+           "in [tails_assay_min, tails_assay_max] that lets its SWU " \
+           "capacity and feed inventory serve the largest fraction of the " \
+           "requested product, preferring the one that uses the least feed " \
+           "among equals. tails_assay is used when there is nothing to bid " \
+           "on." \
+  }
+  bool optimize_tails;
+
+  #pragma cyclus var { \
+    "default": 0.001, \
+    "userlevel": 10, \
+    "tooltip": "lowest tails assay when optimizing", \
+    "uilabel": "Minimum Tails Assay", \
+    "uitype": "range", \
+    "range": [0.0, 0.003], \
+    "doc": "lowest tails assay considered when optimize_tails is on" \
+  }
+  double tails_assay_min;
+
+  #pragma cyclus var { \
+    "default": 0.003, \
+    "userlevel": 10, \
+    "tooltip": "highest tails assay when optimizing", \
+    "uilabel": "Maximum Tails Assay", \
+    "uitype": "range", \
+    "range": [0.0, 0.003], \
+    "doc": "highest tails assay considered when optimize_tails is on; it is " \
+           "also kept below the feed assay" \
+  }
+  double tails_assay_max;
+
   #pragma cyclus var {						       \
     "default": CY_LARGE_DOUBLE,						       \
     "tooltip": "SWU capacity (kgSWU/timestep)",			       \
@@ -395,6 +683,31 @@ class Enrichment
   double intra_timestep_swu_;
   double intra_timestep_feed_;
 
+  // running U-235, U (U-235 + U-238) and total masses of the feed inventory,
+  // so the feed assay can be read without squashing the inventory
+  double feed_u235_;
+  double feed_u_;
+  double feed_qty_;
+
+  // per-timestep offer cache, valid for offer_time_ and offer_feed_assay_:
+  // offer compositions keyed by U-235 atom fraction of uranium, and their
+  // enrichment factors keyed by composition id (shared with the converters)
+  std::map<double, cyclus::Composition::Ptr> offer_comps_;
+  EnrichFactorMap offer_factors_;
+  int offer_time_;
+  double offer_feed_assay_;
+  double offer_tails_assay_;
+
+  // memoized cascade solutions, kept across time steps and rebuilt if
+  // cascade_alpha changes
+  Cascade cascade_;
+
+  // (product, tails) surface for optimize_tails at tails_table_.feed(), and
+  // the tails assay selected for this time step (-1 if none)
+  enum { kTableProducts = 512, kTableTails = 41 };
+  EnrichTable tails_table_;
+  double tails_x_;
+
   friend class EnrichmentTest;
   // ---
 
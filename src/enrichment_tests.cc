@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <sstream>
 
 #include "facility_tests.h"
@@ -9,6 +10,7 @@
 #include "infile_tree.h"
 #include "env.h"
 
+#include "cycamore_log.h"
 #include "enrichment_tests.h"
 
 using cyclus::QueryResult;
@@ -510,8 +512,13 @@ void EnrichmentTest::InitParameters() {
   ctx->AddRecipe(feed_recipe, recipe);
 
   tails_assay = 0.002;
+  max_enrich = 1;
   swu_capacity = 100; //**
   inv_size = 5;
+  coalesce_tails = false;
+  batch_enrich = false;
+  cascade_alpha = 0;
+  optimize_tails = false;
 
   reserves = 105.5;
 }
@@ -527,6 +534,10 @@ void EnrichmentTest::SetUpSource() {
   src_facility->SetMaxInventorySize(inv_size);
   src_facility->SwuCapacity(swu_capacity);
   src_facility->initial_feed = reserves;
+  src_facility->coalesce_tails = coalesce_tails;
+  src_facility->batch_enrich = batch_enrich;
+  src_facility->cascade_alpha = cascade_alpha;
+  src_facility->optimize_tails = optimize_tails;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -557,6 +568,42 @@ EnrichmentTest::DoEnrich(Material::Ptr mat, double qty) {
   return src_facility->Enrich_(mat, qty);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double EnrichmentTest::DoFeedAssay() {
+  return src_facility->FeedAssay();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+cyclus::toolkit::ResBuf<Material>& EnrichmentTest::Inventory() {
+  return src_facility->inventory;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const EnrichFactorMap* EnrichmentTest::OfferFactors() {
+  return &src_facility->offer_factors_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+const Cascade& EnrichmentTest::FacCascade() {
+  return FacCascade();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double EnrichmentTest::DoSelectTails(
+    const std::vector<cyclus::Request<Material>*>& reqs) {
+  src_facility->SelectTails_(reqs);
+  return src_facility->TailsAssay_();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double EnrichmentTest::SquashedFeedAssay() {
+  cyclus::toolkit::ResBuf<Material>& inv = Inventory();
+  Material::Ptr m = cyclus::toolkit::Squash(inv.PopN(inv.count()));
+  double assay = cyclus::toolkit::UraniumAssayMass(m);
+  inv.Push(m);
+  return assay;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST_F(EnrichmentTest, Request) {
   // Tests that quantity in material request is accurate
@@ -642,6 +689,48 @@ TEST_F(EnrichmentTest, ValidReq) {
   EXPECT_NEAR(natuc.convert(target) * mass_frac, natuc.convert(offer), 0.001);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, OfferCache) {
+  // offers for requests of the same product assay share one composition, and
+  // the cached converter factors agree with the full calculation
+  using cyclus::Composition;
+
+  DoAddMat(GetMat(inv_size));
+
+  CompMap v;
+  v[922350000] = 0.05;
+  v[922380000] = 0.95;
+  Material::Ptr t1 = Material::CreateUntracked(
+      3, Composition::CreateFromMass(v));
+  Material::Ptr t2 = Material::CreateUntracked(
+      7, Composition::CreateFromMass(v));
+  v[942390000] = 0.5;  // same product assay, different request composition
+  Material::Ptr t3 = Material::CreateUntracked(
+      2, Composition::CreateFromMass(v));
+
+  Material::Ptr o1 = DoOffer(t1);
+  Material::Ptr o2 = DoOffer(t2);
+  Material::Ptr o3 = DoOffer(t3);
+  EXPECT_EQ(o1->comp(), o2->comp());
+  EXPECT_EQ(o1->comp(), o3->comp());
+  EXPECT_DOUBLE_EQ(7, o2->quantity());
+  EXPECT_EQ(1, OfferFactors()->size());
+
+  SWUConverter swuc(feed_assay, tails_assay);
+  NatUConverter natuc(feed_assay, tails_assay);
+  SWUConverter swuc_cached(feed_assay, tails_assay, OfferFactors());
+  NatUConverter natuc_cached(feed_assay, tails_assay, OfferFactors());
+  EXPECT_NEAR(swuc.convert(o2), swuc_cached.convert(o2), 1e-9);
+  EXPECT_NEAR(natuc.convert(o2), natuc_cached.convert(o2), 1e-9);
+  EXPECT_FALSE(swuc == swuc_cached);
+
+  // a different feed assay invalidates the cache
+  DoAddMat(Material::CreateUntracked(1, c_natu2()));
+  DoOffer(t1);
+  EXPECT_EQ(1, OfferFactors()->size());
+  EXPECT_NE(o1->comp(), DoOffer(t1)->comp());
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST_F(EnrichmentTest, Enrich) {
   // this test asks the facility to enrich a material that results in an amount
@@ -689,6 +778,413 @@ TEST_F(EnrichmentTest, Enrich) {
   EXPECT_THROW(response = DoEnrich(target, qty), cyclus::Error);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, FeedAssayTally) {
+  // the running feed assay must track mixed-assay additions and removals
+  // without squashing the inventory
+  using cyclus::Composition;
+
+  EXPECT_DOUBLE_EQ(0, DoFeedAssay());
+
+  src_facility->SetMaxInventorySize(100);
+  DoAddMat(Material::CreateUntracked(10, c_natu1()));
+  DoAddMat(Material::CreateUntracked(30, c_natu2()));
+  double want = (10 * 0.007 + 30 * 0.01) / 40;
+  EXPECT_NEAR(want, DoFeedAssay(), 1e-12);
+  EXPECT_EQ(2, Inventory().count());
+
+  CompMap v;
+  v[922350000] = 0.05;
+  v[922380000] = 0.95;
+  Material::Ptr target = Material::CreateUntracked(
+      1, Composition::CreateFromMass(v));
+  DoEnrich(target, 1);
+  double got = DoFeedAssay();
+  EXPECT_NEAR(SquashedFeedAssay(), got, 1e-12);
+
+  // materials pushed around AddMat_ are picked up on the next read
+  Inventory().Push(Material::CreateUntracked(20, c_nou235()));
+  EXPECT_NEAR(SquashedFeedAssay(), DoFeedAssay(), 1e-12);
+  EXPECT_GT(got, DoFeedAssay());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, AdjustPrefs) {
+  // bids are ranked by U-235 content under every request, equal-content bids
+  // keep their relative order, and bids without U-235 are refused
+  using cyclus::Bid;
+  using cyclus::Request;
+
+  Material::Ptr target = GetMat(1);
+  Material::Ptr natu1 = Material::CreateUntracked(1, c_natu1());
+  Material::Ptr natu1b = Material::CreateUntracked(2, c_natu1());
+  Material::Ptr natu2 = Material::CreateUntracked(1, c_natu2());
+  Material::Ptr nou235 = Material::CreateUntracked(1, c_nou235());
+
+  cyclus::PrefMap<Material>::type prefs;
+  std::vector<Bid<Material>*> bids;
+  for (int i = 0; i < 2; ++i) {
+    Request<Material>* req =
+        Request<Material>::Create(target, src_facility, feed_commod);
+    Bid<Material>* b2 = Bid<Material>::Create(req, natu2, trader);
+    Bid<Material>* b1 = Bid<Material>::Create(req, natu1, trader);
+    Bid<Material>* b0 = Bid<Material>::Create(req, nou235, trader);
+    Bid<Material>* b1b = Bid<Material>::Create(req, natu1b, trader);
+    prefs[req][b2] = 1;
+    prefs[req][b1] = 1;
+    prefs[req][b0] = 1;
+    prefs[req][b1b] = 1;
+    bids.push_back(b2);
+    bids.push_back(b1);
+    bids.push_back(b0);
+    bids.push_back(b1b);
+  }
+
+  src_facility->AdjustMatlPrefs(prefs);
+
+  cyclus::PrefMap<Material>::type::iterator it;
+  for (it = prefs.begin(); it != prefs.end(); ++it) {
+    std::map<Bid<Material>*, double>& p = it->second;
+    ASSERT_EQ(4, p.size());
+    for (int i = 0; i < bids.size(); i += 4) {
+      if (p.count(bids[i]) == 0) {
+        continue;
+      }
+      EXPECT_EQ(4, p[bids[i]]);
+      EXPECT_EQ(-1, p[bids[i + 2]]);
+      // the two natu1 bids take ranks 2 and 3 in exchange (pointer) order
+      double lo = std::min(p[bids[i + 1]], p[bids[i + 3]]);
+      double hi = std::max(p[bids[i + 1]], p[bids[i + 3]]);
+      EXPECT_EQ(2, lo);
+      EXPECT_EQ(3, hi);
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, AdjustPrefsUnnormalized) {
+  // bids are ranked by U-235 mass fraction, not by the raw recipe values of
+  // recipes that do not sum to one
+  using cyclus::Bid;
+  using cyclus::Composition;
+  using cyclus::Request;
+
+  CompMap v;
+  v[922350000] = 0.7;
+  v[922380000] = 99.3;
+  Material::Ptr natu_pct = Material::CreateUntracked(1,
+      Composition::CreateFromMass(v));
+  Material::Ptr natu = Material::CreateUntracked(1, c_natu1());
+  v[922350000] = 0.0071;
+  v[922380000] = 0.9929;
+  Material::Ptr richer = Material::CreateUntracked(1,
+      Composition::CreateFromMass(v));
+
+  Material::Ptr target = GetMat(1);
+  Request<Material>* req =
+      Request<Material>::Create(target, src_facility, feed_commod);
+  Bid<Material>* b_pct = Bid<Material>::Create(req, natu_pct, trader);
+  Bid<Material>* b_natu = Bid<Material>::Create(req, natu, trader);
+  Bid<Material>* b_richer = Bid<Material>::Create(req, richer, trader);
+  cyclus::PrefMap<Material>::type prefs;
+  prefs[req][b_pct] = 1;
+  prefs[req][b_natu] = 1;
+  prefs[req][b_richer] = 1;
+
+  src_facility->AdjustMatlPrefs(prefs);
+
+  std::map<Bid<Material>*, double>& p = prefs[req];
+  EXPECT_EQ(3, p[b_richer]);
+  // the two equal-assay bids take ranks 1 and 2 in exchange (pointer) order
+  EXPECT_EQ(1, std::min(p[b_pct], p[b_natu]));
+  EXPECT_EQ(2, std::max(p[b_pct], p[b_natu]));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, CoalesceTails) {
+  // repeated enrichments from the same feed leave a single tails entry
+  using cyclus::Composition;
+  using cyclus::toolkit::Assays;
+  using cyclus::toolkit::TailsQty;
+  using cyclus::toolkit::UraniumAssayMass;
+
+  coalesce_tails = true;
+  SetUpSource();
+
+  CompMap v;
+  v[922350000] = 0.05;
+  v[922380000] = 0.95;
+  Material::Ptr target = Material::CreateUntracked(
+      1, Composition::CreateFromMass(v));
+  Assays assays(feed_assay, UraniumAssayMass(target), tails_assay);
+
+  src_facility->SetMaxInventorySize(1000);
+  DoAddMat(GetMat(1000));
+  for (int i = 0; i < 3; ++i) {
+    DoEnrich(target, 1);
+  }
+  EXPECT_EQ(1, src_facility->Tails().count());
+  EXPECT_NEAR(3 * TailsQty(1, assays), src_facility->Tails().quantity(),
+              1e-9);
+
+  // a distinctly different feed gives tails of a new composition
+  Inventory().PopN(Inventory().count());
+  DoAddMat(Material::CreateUntracked(100, c_natu2()));
+  DoEnrich(target, 1);
+  EXPECT_EQ(2, src_facility->Tails().count());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, BatchEnrich) {
+  // the batched path fills the same trades with the same products, feed use
+  // and tails as the per-trade path
+  using cyclus::Bid;
+  using cyclus::Request;
+  using cyclus::Trade;
+  using cyclus::toolkit::MatQuery;
+
+  std::vector<double> want_qty;
+  std::vector<double> want_u235;
+  double want_tails = 0;
+  double want_feed = 0;
+  for (int batch = 0; batch < 2; ++batch) {
+    if (batch) {
+      delete src_facility;
+      src_facility = new Enrichment(tc_.get());
+      batch_enrich = true;
+      SetUpSource();
+    }
+    src_facility->SetMaxInventorySize(1000);
+    DoAddMat(GetMat(1000));
+
+    std::vector<Trade<Material> > trades;
+    double assays[] = {0.04, 0.05, 0.04};
+    for (int i = 0; i < 3; ++i) {
+      CompMap v;
+      v[922350000] = assays[i];
+      v[922380000] = 1 - assays[i];
+      Material::Ptr target = Material::CreateUntracked(
+          2, cyclus::Composition::CreateFromMass(v));
+      Request<Material>* req =
+          Request<Material>::Create(target, trader, product_commod);
+      Bid<Material>* bid = Bid<Material>::Create(req, DoOffer(target),
+                                                 src_facility);
+      trades.push_back(Trade<Material>(req, bid, 1 + i));
+    }
+
+    std::vector<std::pair<Trade<Material>, Material::Ptr> > responses;
+    src_facility->GetMatlTrades(trades, responses);
+    ASSERT_EQ(3, responses.size());
+
+    // responses may come back grouped, so line them up by trade amount
+    std::map<double, Material::Ptr> got;
+    for (int i = 0; i < responses.size(); ++i) {
+      got[responses[i].first.amt] = responses[i].second;
+    }
+    std::map<double, Material::Ptr>::iterator it;
+    int i = 0;
+    for (it = got.begin(); it != got.end(); ++it, ++i) {
+      MatQuery mq(it->second);
+      if (!batch) {
+        want_qty.push_back(it->second->quantity());
+        want_u235.push_back(mq.mass(922350000));
+      } else {
+        EXPECT_NEAR(want_qty[i], it->second->quantity(), 1e-9);
+        EXPECT_NEAR(want_u235[i], mq.mass(922350000), 1e-9);
+      }
+    }
+    if (!batch) {
+      want_tails = src_facility->Tails().quantity();
+      want_feed = Inventory().quantity();
+    } else {
+      EXPECT_NEAR(want_tails, src_facility->Tails().quantity(), 1e-9);
+      EXPECT_NEAR(want_feed, Inventory().quantity(), 1e-9);
+      EXPECT_EQ(1, src_facility->Tails().count());
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, Cascade) {
+  // the cascade model reduces to the ideal formulas when whole stages hit
+  // the requested assays exactly, approaches them as alpha goes to 1, and
+  // conserves U-235 when blending down overshoot
+  using cyclus::toolkit::Assays;
+  using cyclus::toolkit::FeedQty;
+  using cyclus::toolkit::SwuRequired;
+
+  double xf = 0.0072;
+  Assays ideal(xf, 0.04, 0.002);
+
+  Cascade off;
+  EXPECT_FALSE(off.enabled());
+  EXPECT_DOUBLE_EQ(SwuRequired(1, ideal), off.Solve(xf, 0.04, 0.002).swu);
+  EXPECT_DOUBLE_EQ(FeedQty(1, ideal), off.Solve(xf, 0.04, 0.002).feed);
+
+  // 10 enriching and 5 stripping stages at alpha = 1.5
+  Cascade c(1.5);
+  double beta = std::sqrt(1.5);
+  double rf = xf / (1 - xf);
+  double rp = rf * std::pow(beta, 10);
+  double rw = rf / std::pow(beta, 5);
+  double xp = rp / (1 + rp);
+  double xw = rw / (1 + rw);
+  Assays exact(xf, xp, xw);
+  const Cascade::Solution& s = c.Solve(xf, xp, xw);
+  EXPECT_EQ(10, s.enriching);
+  EXPECT_EQ(5, s.stripping);
+  EXPECT_NEAR(SwuRequired(1, exact), s.swu, 1e-9);
+  EXPECT_NEAR(FeedQty(1, exact), s.feed, 1e-9);
+
+  // overshoot is blended down, and U-235 balances at the cascade tails
+  const Cascade::Solution& b = c.Solve(xf, 0.04, 0.002);
+  EXPECT_LE(0.04, b.product);
+  EXPECT_GE(0.002, b.tails);
+  EXPECT_NEAR(b.feed * xf, 0.04 + (b.feed - 1) * b.tails, 1e-12);
+
+  Cascade fine(1.0001);
+  EXPECT_NEAR(SwuRequired(1, ideal), fine.Solve(xf, 0.04, 0.002).swu, 1e-3);
+  EXPECT_NEAR(FeedQty(1, ideal), fine.Solve(xf, 0.04, 0.002).feed, 1e-3);
+
+  // solutions are memoized
+  EXPECT_EQ(2, c.size());
+  EXPECT_EQ(&b, &c.Solve(xf, 0.04, 0.002));
+  EXPECT_EQ(2, c.size());
+
+  // up to capacity, dropping the least recently used solution first
+  Cascade memo(1.5, 2);
+  const Cascade::Solution* kept = &memo.Solve(xf, 0.04, 0.002);
+  memo.Solve(xf, 0.05, 0.002);
+  memo.Solve(xf, 0.04, 0.002);
+  memo.Solve(xf, 0.06, 0.002);
+  EXPECT_EQ(2, memo.size());
+  EXPECT_EQ(kept, &memo.Solve(xf, 0.04, 0.002));
+  EXPECT_EQ(2, memo.size());
+  EXPECT_EQ(b.swu, kept->swu);
+
+  // the facility enriches with the cascade solution
+  cascade_alpha = 1.5;
+  SetUpSource();
+  CompMap v;
+  v[922350000] = 0.04;
+  v[922380000] = 0.96;
+  Material::Ptr target = Material::CreateUntracked(
+      1, cyclus::Composition::CreateFromMass(v));
+  src_facility->SetMaxInventorySize(100);
+  DoAddMat(GetMat(100));
+  const Cascade::Solution& want = c.Solve(feed_assay, 0.04, tails_assay);
+  DoEnrich(target, 2);
+  EXPECT_NEAR(2 * (want.feed - 1), src_facility->Tails().quantity(), 1e-9);
+  EXPECT_NEAR(100 - 2 * want.feed, Inventory().quantity(), 1e-9);
+
+  // and its memo carries over to the next time step
+  const Cascade::Solution* prev =
+      &FacCascade().Solve(feed_assay, 0.04, tails_assay);
+  int n = FacCascade().size();
+  src_facility->Tick();
+  EXPECT_EQ(n, FacCascade().size());
+  EXPECT_EQ(prev,
+            &FacCascade().Solve(feed_assay, 0.04, tails_assay));
+  EXPECT_EQ(n, FacCascade().size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, EnrichTable) {
+  // the tabulated surface reproduces the ideal formulas on grid points and
+  // interpolates closely between them
+  using cyclus::toolkit::Assays;
+  using cyclus::toolkit::FeedQty;
+  using cyclus::toolkit::SwuRequired;
+
+  EnrichTable t;
+  EXPECT_TRUE(t.empty());
+  t.Build(Cascade(), feed_assay, feed_assay, 0.2, 128, 0.001, 0.003, 41);
+  EXPECT_EQ(41, t.ntails());
+  EXPECT_NEAR(0.003, t.tails(40), 1e-15);
+
+  double p_on = feed_assay + 64 * (0.2 - feed_assay) / 127;
+  Assays on(feed_assay, p_on, t.tails(10));
+  EXPECT_NEAR(SwuRequired(1, on), t.Lookup(p_on, t.tails(10)).swu, 1e-9);
+  EXPECT_NEAR(FeedQty(1, on), t.Lookup(p_on, t.tails(10)).feed, 1e-9);
+
+  Assays off(feed_assay, 0.0437, 0.00213);
+  EXPECT_NEAR(SwuRequired(1, off), t.Lookup(0.0437, 0.00213).swu,
+              1e-3 * SwuRequired(1, off));
+  EXPECT_NEAR(FeedQty(1, off), t.Lookup(0.0437, 0.00213).feed,
+              1e-3 * FeedQty(1, off));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(EnrichmentTest, SelectTails) {
+  // a SWU-limited facility raises its tails assay to spend less SWU per kg,
+  // and a feed-limited one lowers it to spend less feed
+  using cyclus::Request;
+
+  CompMap v;
+  v[922350000] = 0.04;
+  v[922380000] = 0.96;
+  Material::Ptr target = Material::CreateUntracked(
+      10, cyclus::Composition::CreateFromMass(v));
+  std::vector<Request<Material>*> reqs;
+  reqs.push_back(Request<Material>::Create(target, trader, product_commod));
+
+  // disabled: the configured tails assay
+  src_facility->SetMaxInventorySize(1000);
+  DoAddMat(GetMat(1000));
+  EXPECT_DOUBLE_EQ(tails_assay, DoSelectTails(reqs));
+
+  optimize_tails = true;
+  SetUpSource();
+  src_facility->SetMaxInventorySize(1000);
+  src_facility->SwuCapacity(1);
+  EXPECT_NEAR(0.003, DoSelectTails(reqs), 1e-12);
+
+  src_facility->SwuCapacity(1e6);
+  Inventory().PopN(Inventory().count());
+  DoAddMat(GetMat(10));
+  EXPECT_NEAR(0.001, DoSelectTails(reqs), 1e-12);
+
+  // feed without U-235: the configured tails assay
+  Inventory().PopN(Inventory().count());
+  Inventory().Push(Material::CreateUntracked(10, c_nou235()));
+  EXPECT_DOUBLE_EQ(tails_assay, DoSelectTails(reqs));
+
+  // nothing to bid on: back to the configured tails assay
+  reqs.clear();
+  EXPECT_DOUBLE_EQ(tails_assay, DoSelectTails(reqs));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+static int log_evals = 0;
+static double CountLogEval() {
+  ++log_evals;
+  return 0;
+}
+
+TEST_F(EnrichmentTest, LogGate) {
+  // nothing streamed into a disabled log statement is evaluated
+  cyclus::LogLevel prev = cyclus::Logger::ReportLevel();
+  cyclus::Logger::ReportLevel() = cyclus::LEV_ERROR;
+  log_evals = 0;
+  EXPECT_FALSE(CYCAMORE_LOG_ENABLED(cyclus::LEV_INFO5));
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << CountLogEval();
+  EXPECT_EQ(0, log_evals);
+
+  // nor is anything in an enrichment report
+  CompMap v;
+  v[922350000] = 0.05;
+  v[922380000] = 0.95;
+  src_facility->SetMaxInventorySize(100);
+  DoAddMat(GetMat(100));
+  EXPECT_NO_THROW(DoEnrich(Material::CreateUntracked(
+      1, cyclus::Composition::CreateFromMass(v)), 1));
+
+  cyclus::Logger::ReportLevel() = cyclus::LEV_INFO5;
+  CYCAMORE_LOG(cyclus::LEV_INFO5, "EnrFac") << CountLogEval();
+  EXPECT_EQ(cyclus::LEV_INFO5 <= CYCAMORE_MAX_LOG_LEVEL ? 1 : 0, log_evals);
+  cyclus::Logger::ReportLevel() = prev;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST_F(EnrichmentTest, Response) {
   // this test asks the facility to respond to multiple requests for enriched
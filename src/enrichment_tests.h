@@ -24,8 +24,9 @@ class EnrichmentTest : public ::testing::Test {
   TestFacility* trader;
 
   double feed_assay, tails_assay, inv_size, swu_capacity, max_enrich;
+  double cascade_alpha;
 
-  bool order_prefs;
+  bool order_prefs, coalesce_tails, batch_enrich, optimize_tails;
 
   double reserves;
 
@@ -41,6 +42,15 @@ class EnrichmentTest : public ::testing::Test {
   cyclus::Material::Ptr DoBid(cyclus::Material::Ptr mat);
   cyclus::Material::Ptr DoOffer(cyclus::Material::Ptr mat);
   cyclus::Material::Ptr DoEnrich(cyclus::Material::Ptr mat, double qty);
+  double DoFeedAssay();
+  cyclus::toolkit::ResBuf<cyclus::Material>& Inventory();
+  const EnrichFactorMap* OfferFactors();
+  const Cascade& FacCascade();
+  /// @returns the tails assay selected for the given product requests
+  double DoSelectTails(
+      const std::vector<cyclus::Request<cyclus::Material>*>& reqs);
+  /// @returns the feed assay computed by squashing the whole inventory
+  double SquashedFeedAssay();
   /// @param nreqs the total number of requests
   /// @param nvalid the number of requests that are valid
   boost::shared_ptr< cyclus::ExchangeContext<cyclus::Material> >
@@ -1,6 +1,8 @@
 #include "fuel_fab.h"
 
+#include <algorithm>
 #include <sstream>
+#include <typeinfo>
 
 using cyclus::Material;
 using cyclus::Composition;
@@ -12,123 +14,74 @@ using pyne::simple_xs;
 
 namespace cycamore {
 
-class FissConverter : public cyclus::Converter<Material> {
- public:
-  FissConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
-                Composition::Ptr c_topup, std::string spectrum)
-      : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), spec_(spectrum) {
-    w_fiss_ = CosiWeight(c_fiss, spectrum);
-    w_fill_ = CosiWeight(c_fill, spectrum);
-    w_topup_ = CosiWeight(c_topup, spectrum);
-  }
-
-  virtual ~FissConverter() {}
-
-  virtual double convert(
-      Material::Ptr m, cyclus::Arc const* a = NULL,
-      cyclus::ExchangeTranslationContext<Material> const* ctx =
-          NULL) const {
-    double w_tgt = CosiWeight(m->comp(), spec_);
-    if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
-      double frac = HighFrac(w_fill_, w_tgt, w_fiss_);
-      return AtomToMassFrac(frac, c_fiss_, c_fill_) * m->quantity();
-    } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
-      // use fiss inventory as filler, and topup as fissile
-      double frac = LowFrac(w_fiss_, w_tgt, w_topup_);
-      return AtomToMassFrac(frac, c_fiss_, c_topup_) * m->quantity();
-    } else {
-      // don't bid at all
-      return cyclus::CY_LARGE_DOUBLE;
-    }
+MixConverter::MixConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
+                           Composition::Ptr c_topup,
+                           CosiWeightCache::Ptr weights)
+    : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), weights_(weights) {
+  w_fiss_ = weights->Weight(c_fiss);
+  w_fill_ = weights->Weight(c_fill);
+  w_topup_ = weights->Weight(c_topup);
+}
+
+double MixConverter::convert(
+    Material::Ptr m, cyclus::Arc const* a,
+    cyclus::ExchangeTranslationContext<Material> const* ctx) const {
+  int id = m->comp()->id();
+  std::map<int, double>::iterator it = ratios_.find(id);
+  if (it == ratios_.end()) {
+    double r = Ratio(weights_->Weight(m->comp()));
+    it = ratios_.insert(std::make_pair(id, r)).first;
+  }
+  if (it->second == cyclus::CY_LARGE_DOUBLE) {
+    // don't bid at all
+    return cyclus::CY_LARGE_DOUBLE;
   }
+  return it->second * m->quantity();
+}
 
- private:
-  std::string spec_;
-  double w_fiss_;
-  double w_topup_;
-  double w_fill_;
-  Composition::Ptr c_fiss_;
-  Composition::Ptr c_fill_;
-  Composition::Ptr c_topup_;
-};
-
-class FillConverter : public cyclus::Converter<Material> {
- public:
-  FillConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
-                Composition::Ptr c_topup, std::string spectrum)
-      : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), spec_(spectrum) {
-    w_fiss_ = CosiWeight(c_fiss, spectrum);
-    w_fill_ = CosiWeight(c_fill, spectrum);
-    w_topup_ = CosiWeight(c_topup, spectrum);
-  }
-
-  virtual ~FillConverter() {}
-
-  virtual double convert(
-      Material::Ptr m, cyclus::Arc const* a = NULL,
-      cyclus::ExchangeTranslationContext<Material> const* ctx =
-          NULL) const {
-    double w_tgt = CosiWeight(m->comp(), spec_);
-    if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
-      double frac = LowFrac(w_fill_, w_tgt, w_fiss_);
-      return AtomToMassFrac(frac, c_fill_, c_fiss_) * m->quantity();
-    } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
-      // switched fissile inventory to filler so don't need any filler inventory
-      return 0;
-    } else {
-      // don't bid at all
-      return cyclus::CY_LARGE_DOUBLE;
-    }
+bool MixConverter::operator==(Converter& other) const {
+  MixConverter* cast = dynamic_cast<MixConverter*>(&other);
+  return cast != NULL &&
+  typeid(*this) == typeid(*cast) &&
+  c_fiss_->id() == cast->c_fiss_->id() &&
+  c_fill_->id() == cast->c_fill_->id() &&
+  c_topup_->id() == cast->c_topup_->id() &&
+  &weights_->xs() == &cast->weights_->xs();
+}
+
+double FissConverter::Ratio(double w_tgt) const {
+  if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
+    double frac = HighFrac(w_fill_, w_tgt, w_fiss_);
+    return weights_->AtomToMassFrac(frac, c_fiss_, c_fill_);
+  } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
+    // use fiss inventory as filler, and topup as fissile
+    double frac = LowFrac(w_fiss_, w_tgt, w_topup_);
+    return weights_->AtomToMassFrac(frac, c_fiss_, c_topup_);
   }
+  return cyclus::CY_LARGE_DOUBLE;
+}
 
- private:
-  std::string spec_;
-  double w_fiss_;
-  double w_topup_;
-  double w_fill_;
-  Composition::Ptr c_fiss_;
-  Composition::Ptr c_fill_;
-  Composition::Ptr c_topup_;
-};
-
-class TopupConverter : public cyclus::Converter<Material> {
- public:
-  TopupConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
-                 Composition::Ptr c_topup, std::string spectrum)
-      : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), spec_(spectrum) {
-    w_fiss_ = CosiWeight(c_fiss, spectrum);
-    w_fill_ = CosiWeight(c_fill, spectrum);
-    w_topup_ = CosiWeight(c_topup, spectrum);
-  }
-
-  virtual ~TopupConverter() {}
-
-  virtual double convert(
-      Material::Ptr m, cyclus::Arc const* a = NULL,
-      cyclus::ExchangeTranslationContext<Material> const* ctx =
-          NULL) const {
-    double w_tgt = CosiWeight(m->comp(), spec_);
-    if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
-      return 0;
-    } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
-      // switched fissile inventory to filler and topup as fissile
-      double frac = HighFrac(w_fiss_, w_tgt, w_topup_);
-      return AtomToMassFrac(frac, c_topup_, c_fiss_) * m->quantity();
-    } else {
-      // don't bid at all
-      return cyclus::CY_LARGE_DOUBLE;
-    }
+double FillConverter::Ratio(double w_tgt) const {
+  if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
+    double frac = LowFrac(w_fill_, w_tgt, w_fiss_);
+    return weights_->AtomToMassFrac(frac, c_fill_, c_fiss_);
+  } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
+    // switched fissile inventory to filler so don't need any filler inventory
+    return 0;
   }
+  return cyclus::CY_LARGE_DOUBLE;
+}
 
- private:
-  std::string spec_;
-  double w_fiss_;
-  double w_topup_;
-  double w_fill_;
-  Composition::Ptr c_fiss_;
-  Composition::Ptr c_fill_;
-  Composition::Ptr c_topup_;
-};
+double TopupConverter::Ratio(double w_tgt) const {
+  if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
+    return 0;
+  } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
+    // switched fissile inventory to filler and topup as fissile
+    double frac = HighFrac(w_fiss_, w_tgt, w_topup_);
+    return weights_->AtomToMassFrac(frac, c_topup_, c_fiss_);
+  }
+  return cyclus::CY_LARGE_DOUBLE;
+}
 
 FuelFab::FuelFab(cyclus::Context* ctx)
     : cyclus::Facility(ctx),
@@ -161,9 +114,16 @@ void FuelFab::EnterNotify() {
     throw cyclus::ValidationError(ss.str());
   }
 
+  weights_ = CosiWeightCache::Ptr(
+      new CosiWeightCache(NucWeightTable::Get(spectrum)));
+
   InitializePosition();
 }
 
+void FuelFab::Tick() {
+  weights_->Clear();
+}
+
 std::set<cyclus::RequestPortfolio<Material>::Ptr> FuelFab::GetMatlRequests() {
   using cyclus::RequestPortfolio;
 
@@ -287,71 +247,51 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> FuelFab::GetMatlBids(
     return ports;
   }
 
-  double w_fill = 0;
   Composition::Ptr
       c_fill;  // no default needed - this is non-optional parameter
   if (fill.count() > 0) {
     c_fill = fill.Peek()->comp();
-    w_fill = CosiWeight(c_fill, spectrum);
   } else {
     c_fill = context()->GetRecipe(fill_recipe);
-    w_fill = CosiWeight(c_fill, spectrum);
   }
 
-  double w_topup = 0;
   Composition::Ptr c_topup = c_fill;
   if (topup.count() > 0) {
     c_topup = topup.Peek()->comp();
-    w_topup = CosiWeight(c_topup, spectrum);
   } else if (!topup_recipe.empty()) {
     c_topup = context()->GetRecipe(topup_recipe);
-    w_topup = CosiWeight(c_topup, spectrum);
   }
 
-  double w_fiss =
-      w_fill;  // this allows trading just fill with no fiss inventory
+  // this allows trading just fill with no fiss inventory
   Composition::Ptr c_fiss = c_fill;
   if (fiss.count() > 0) {
     c_fiss = fiss.Peek()->comp();
-    w_fiss = CosiWeight(c_fiss, spectrum);
   } else if (!fiss_recipe.empty()) {
     c_fiss = context()->GetRecipe(fiss_recipe);
-    w_fiss = CosiWeight(c_fiss, spectrum);
   }
 
+  // Most requests share a handful of target recipes and the offered mixture
+  // only depends on the target composition (not the quantity), so mix each
+  // distinct target once and bid the same composition for every request for
+  // it.  Targets the streams can't mix to map to a null composition.
+  std::map<int, Composition::Ptr> offers;
+
   BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
   for (int j = 0; j < reqs.size(); j++) {
     cyclus::Request<Material>* req = reqs[j];
 
     Composition::Ptr tgt = req->target()->comp();
-    double w_tgt = CosiWeight(tgt, spectrum);
-    double tgt_qty = req->target()->quantity();
-    if (ValidWeights(w_fill, w_tgt, w_fiss)) {
-      double fiss_frac = HighFrac(w_fill, w_tgt, w_fiss);
-      double fill_frac = 1 - fiss_frac;
-      fiss_frac = AtomToMassFrac(fiss_frac, c_fiss, c_fill);
-      fill_frac = AtomToMassFrac(fill_frac, c_fill, c_fiss);
-      Material::Ptr m1 = Material::CreateUntracked(fiss_frac * tgt_qty, c_fiss);
-      Material::Ptr m2 = Material::CreateUntracked(fill_frac * tgt_qty, c_fill);
-      m1->Absorb(m2);
-
-      bool exclusive = false;
-      port->AddBid(req, m1, this, exclusive);
-    } else if (topup.count() > 0 && ValidWeights(w_fiss, w_tgt, w_topup)) {
-      // only bid with topup if we have filler - otherwise we might be able to
-      // meet target with filler when we get it. we should only use topup
-      // when the fissile has too poor neutronics.
-      double topup_frac = HighFrac(w_fiss, w_tgt, w_topup);
-      double fiss_frac = 1 - topup_frac;
-      fiss_frac = AtomToMassFrac(fiss_frac, c_fiss, c_topup);
-      topup_frac = AtomToMassFrac(topup_frac, c_topup, c_fiss);
-      Material::Ptr m1 =
-          Material::CreateUntracked(topup_frac * tgt_qty, c_topup);
-      Material::Ptr m2 = Material::CreateUntracked(fiss_frac * tgt_qty, c_fiss);
-      m1->Absorb(m2);
+    std::map<int, Composition::Ptr>::iterator it = offers.find(tgt->id());
+    if (it == offers.end()) {
+      Composition::Ptr offer = MixOffer(tgt, c_fill, c_fiss, c_topup);
+      it = offers.insert(std::make_pair(tgt->id(), offer)).first;
+    }
 
+    if (it->second) {
+      double tgt_qty = req->target()->quantity();
+      Material::Ptr m = Material::CreateUntracked(tgt_qty, it->second);
       bool exclusive = false;
-      port->AddBid(req, m1, this, exclusive);
+      port->AddBid(req, m, this, exclusive);
     } else if (fiss.count() > 0 && fill.count() > 0 ||
                fiss.count() > 0 && topup.count() > 0) {
       // else can't meet the target weight - don't bid.  Just a plain else
@@ -366,11 +306,11 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> FuelFab::GetMatlBids(
   }
 
   cyclus::Converter<Material>::Ptr fissconv(
-      new FissConverter(c_fill, c_fiss, c_topup, spectrum));
+      new FissConverter(c_fill, c_fiss, c_topup, weights_));
   cyclus::Converter<Material>::Ptr fillconv(
-      new FillConverter(c_fill, c_fiss, c_topup, spectrum));
+      new FillConverter(c_fill, c_fiss, c_topup, weights_));
   cyclus::Converter<Material>::Ptr topupconv(
-      new TopupConverter(c_fill, c_fiss, c_topup, spectrum));
+      new TopupConverter(c_fill, c_fiss, c_topup, weights_));
   // important! - the std::max calls prevent CapacityConstraint throwing a zero
   // cap exception
   cyclus::CapacityConstraint<Material> fissc(std::max(fiss.quantity(), cyclus::CY_NEAR_ZERO),
@@ -389,6 +329,39 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> FuelFab::GetMatlBids(
   return ports;
 }
 
+Composition::Ptr FuelFab::MixOffer(Composition::Ptr tgt,
+                                   Composition::Ptr c_fill,
+                                   Composition::Ptr c_fiss,
+                                   Composition::Ptr c_topup) {
+  double w_fill = weights_->Weight(c_fill);
+  double w_fiss = weights_->Weight(c_fiss);
+  double w_topup = weights_->Weight(c_topup);
+  double w_tgt = weights_->Weight(tgt);
+
+  Material::Ptr m;
+  if (ValidWeights(w_fill, w_tgt, w_fiss)) {
+    double fiss_frac = HighFrac(w_fill, w_tgt, w_fiss);
+    double fill_frac = 1 - fiss_frac;
+    fiss_frac = weights_->AtomToMassFrac(fiss_frac, c_fiss, c_fill);
+    fill_frac = weights_->AtomToMassFrac(fill_frac, c_fill, c_fiss);
+    m = Material::CreateUntracked(fiss_frac, c_fiss);
+    m->Absorb(Material::CreateUntracked(fill_frac, c_fill));
+  } else if (topup.count() > 0 && ValidWeights(w_fiss, w_tgt, w_topup)) {
+    // only bid with topup if we have filler - otherwise we might be able to
+    // meet target with filler when we get it. we should only use topup
+    // when the fissile has too poor neutronics.
+    double topup_frac = HighFrac(w_fiss, w_tgt, w_topup);
+    double fiss_frac = 1 - topup_frac;
+    fiss_frac = weights_->AtomToMassFrac(fiss_frac, c_fiss, c_topup);
+    topup_frac = weights_->AtomToMassFrac(topup_frac, c_topup, c_fiss);
+    m = Material::CreateUntracked(topup_frac, c_topup);
+    m->Absorb(Material::CreateUntracked(fiss_frac, c_fiss));
+  } else {
+    return Composition::Ptr();
+  }
+  return m->comp();
+}
+
 void FuelFab::GetMatlTrades(
     const std::vector<cyclus::Trade<Material> >& trades,
     std::vector<std::pair<cyclus::Trade<Material>, Material::Ptr> >&
@@ -399,15 +372,15 @@ void FuelFab::GetMatlTrades(
   // trades may not need that particular buffer.
   double w_fill = 0;
   if (fill.count() > 0) {
-    w_fill = CosiWeight(fill.Peek()->comp(), spectrum);
+    w_fill = weights_->Weight(fill.Peek()->comp());
   }
   double w_topup = 0;
   if (topup.count() > 0) {
-    w_topup = CosiWeight(topup.Peek()->comp(), spectrum);
+    w_topup = weights_->Weight(topup.Peek()->comp());
   }
   double w_fiss = 0;
   if (fiss.count() > 0) {
-    w_fiss = CosiWeight(fiss.Peek()->comp(), spectrum);
+    w_fiss = weights_->Weight(fiss.Peek()->comp());
   }
 
   std::vector<cyclus::Trade<Material> >::const_iterator it;
@@ -415,7 +388,7 @@ void FuelFab::GetMatlTrades(
   for (int i = 0; i < trades.size(); i++) {
     Material::Ptr tgt = trades[i].request->target();
 
-    double w_tgt = CosiWeight(tgt->comp(), spectrum);
+    double w_tgt = weights_->Weight(tgt->comp());
     double qty = trades[i].amt;
     double wfiss = w_fiss;
 
@@ -447,9 +420,11 @@ void FuelFab::GetMatlTrades(
       double fiss_frac = HighFrac(w_fill, w_tgt, w_fiss);
       double fill_frac = LowFrac(w_fill, w_tgt, w_fiss);
       fiss_frac =
-          AtomToMassFrac(fiss_frac, fiss.Peek()->comp(), fill.Peek()->comp());
+          weights_->AtomToMassFrac(fiss_frac, fiss.Peek()->comp(),
+                                   fill.Peek()->comp());
       fill_frac =
-          AtomToMassFrac(fill_frac, fill.Peek()->comp(), fiss.Peek()->comp());
+          weights_->AtomToMassFrac(fill_frac, fill.Peek()->comp(),
+                                   fiss.Peek()->comp());
 
       double fissqty = fiss_frac * qty;
       if (std::abs(fissqty - fiss.quantity()) < cyclus::eps_rsrc()) {
@@ -470,9 +445,11 @@ void FuelFab::GetMatlTrades(
       double topup_frac = HighFrac(w_fiss, w_tgt, w_topup);
       double fiss_frac = 1 - topup_frac;
       topup_frac =
-          AtomToMassFrac(topup_frac, topup.Peek()->comp(), fiss.Peek()->comp());
+          weights_->AtomToMassFrac(topup_frac, topup.Peek()->comp(),
+                                   fiss.Peek()->comp());
       fiss_frac =
-          AtomToMassFrac(fiss_frac, fiss.Peek()->comp(), topup.Peek()->comp());
+          weights_->AtomToMassFrac(fiss_frac, fiss.Peek()->comp(),
+                                   topup.Peek()->comp());
 
       double fissqty = fiss_frac * qty;
       if (std::abs(fissqty - fiss.quantity()) < cyclus::eps_rsrc()) {
@@ -511,195 +488,179 @@ extern "C" cyclus::Agent* ConstructFuelFab(cyclus::Context* ctx) {
 // material/mixing fractions will also be atom-based naturally and will need
 // to be converted to mass-based for actual material object mixing.
 double CosiWeight(Composition::Ptr c, const std::string& spectrum) {
-  cyclus::CompMap cm = c->atom();
-  cyclus::compmath::Normalize(&cm);
-
-  if (spectrum == "thermal") {
-    double nu_pu239 = 2.85;
-    double nu_u233 = 2.5;
-    double nu_u235 = 2.43;
-    double nu_u238 = 0;
-    double nu_pu241 = nu_pu239;
-
-    static std::map<int, double> absorb_xs;
-    static std::map<int, double> fiss_xs;
-    static double p_u238 = 0;
-    static double p_pu239 = 0;
-    if (p_u238 == 0) {
-      double fiss_u238 = simple_xs(922380000, "fission", "thermal");
-      double absorb_u238 = simple_xs(922380000, "absorption", "thermal");
-      p_u238 = nu_u238 * fiss_u238 - absorb_u238;
-
-      double fiss_pu239 = simple_xs(942390000, "fission", "thermal");
-      double absorb_pu239 = simple_xs(942390000, "absorption", "thermal");
-      p_pu239 = nu_pu239 * fiss_pu239 - absorb_pu239;
-    }
+  return CosiWeight(c, NucWeightTable::Get(spectrum));
+}
 
-    cyclus::CompMap::iterator it;
-    double w = 0;
-    for (it = cm.begin(); it != cm.end(); ++it) {
-      cyclus::Nuc nuc = it->first;
-      double nu = 0;
-      if (nuc == 922350000) {
-        nu = nu_u235;
-      } else if (nuc == 922330000) {
-        nu = nu_u233;
-      } else if (nuc == 942390000) {
-        nu = nu_pu239;
-      } else if (nuc == 942410000) {
-        nu = nu_pu241;
-      }
+double CosiWeight(Composition::Ptr c, const NucWeightTable& xs) {
+  return CompView(c, &xs).Weight();
+}
 
-      double fiss = 0;
-      double absorb = 0;
-      if (absorb_xs.count(nuc) == 0) {
-        try {
-          fiss = simple_xs(nuc, "fission", "thermal");
-          absorb = simple_xs(nuc, "absorption", "thermal");
-          absorb_xs[nuc] = absorb;
-          fiss_xs[nuc] = fiss;
-        } catch (pyne::InvalidSimpleXS err) {
-          fiss = 0;
-          absorb = 0;
-        }
-      } else {
-        fiss = fiss_xs[nuc];
-        absorb = absorb_xs[nuc];
-      }
+// Returns the average number of neutrons per fission used for nuc in CosiWeight
+// calculations with the given spectrum.
+double CosiNu(cyclus::Nuc nuc, const std::string& spectrum) {
+  bool thermal = spectrum == "thermal";
+  if (nuc == 922350000) {
+    return thermal ? 2.43 : 2.58;
+  } else if (nuc == 922330000) {
+    return thermal ? 2.5 : 2.63;
+  } else if (nuc == 942390000 || nuc == 942410000) {
+    return thermal ? 2.85 : 3.1;
+  }
+  return 0;
+}
 
-      double p = nu * fiss - absorb;
-      w += it->second * (p - p_u238) / (p_pu239 - p_u238);
-    }
-    return w;
-  } else if (spectrum == "fission_spectrum_ave") {
-    double nu_pu239 = 3.1;
-    double nu_u233 = 2.63;
-    double nu_u235 = 2.58;
-    double nu_u238 = 0;
-    double nu_pu241 = nu_pu239;
-
-    static std::map<int, double> absorb_xs;
-    static std::map<int, double> fiss_xs;
-    static double p_u238 = 0;
-    static double p_pu239 = 0;
-    if (p_u238 == 0) {
-      double fiss_u238 =
-          simple_xs(922380000, "fission", "fission_spectrum_ave");
-      double absorb_u238 =
-          simple_xs(922380000, "absorption", "fission_spectrum_ave");
-      p_u238 = nu_u238 * fiss_u238 - absorb_u238;
-
-      double fiss_pu239 =
-          simple_xs(942390000, "fission", "fission_spectrum_ave");
-      double absorb_pu239 =
-          simple_xs(942390000, "absorption", "fission_spectrum_ave");
-      p_pu239 = nu_pu239 * fiss_pu239 - absorb_pu239;
+NucWeightTable::NucWeightTable(std::string spectrum) : spectrum_(spectrum) {
+  p_u238_ = CosiNu(922380000, spectrum) *
+                simple_xs(922380000, "fission", spectrum) -
+            simple_xs(922380000, "absorption", spectrum);
+  p_pu239_ = CosiNu(942390000, spectrum) *
+                 simple_xs(942390000, "fission", spectrum) -
+             simple_xs(942390000, "absorption", spectrum);
+
+  // The simple cross section library has no nuclide listing, so probe every
+  // nuclide with a known atomic mass along with its first metastable state.
+  // Probing in set order keeps nucs_ sorted for the binary search in p().
+  // Misses are stored as explicit zeros so p() only has to go back to pyne
+  // for nuclides that were never probed.
+  pyne::atomic_mass(922380000);  // makes sure the mass map is loaded
+  std::set<cyclus::Nuc> candidates;
+  std::map<int, double>::iterator it;
+  for (it = pyne::atomic_mass_map.begin(); it != pyne::atomic_mass_map.end();
+       ++it) {
+    candidates.insert(it->first);
+    candidates.insert(it->first + 1);
+  }
+
+  std::set<cyclus::Nuc>::iterator nuc;
+  for (nuc = candidates.begin(); nuc != candidates.end(); ++nuc) {
+    try {
+      double fiss = simple_xs(*nuc, "fission", spectrum);
+      double absorb = simple_xs(*nuc, "absorption", spectrum);
+      nucs_.push_back(*nuc);
+      ps_.push_back(CosiNu(*nuc, spectrum) * fiss - absorb);
+    } catch (pyne::InvalidSimpleXS err) {
+      nucs_.push_back(*nuc);  // no data - p is zero
+      ps_.push_back(0);
     }
+  }
+}
 
-    cyclus::CompMap::iterator it;
-    double w = 0;
-    for (it = cm.begin(); it != cm.end(); ++it) {
-      cyclus::Nuc nuc = it->first;
-      double nu = 0;
-      if (nuc == 922350000) {
-        nu = nu_u235;
-      } else if (nuc == 922330000) {
-        nu = nu_u233;
-      } else if (nuc == 942390000) {
-        nu = nu_pu239;
-      } else if (nuc == 942410000) {
-        nu = nu_pu241;
-      }
+// Builds the table for every spectrum in the simple cross section library.
+std::map<std::string, NucWeightTable> BuildNucWeightTables() {
+  const char* spectra[] = {"thermal", "thermal_maxwell_ave",
+                           "fission_spectrum_ave", "resonance_integral",
+                           "fourteen_MeV"};
+  std::map<std::string, NucWeightTable> tables;
+  for (int i = 0; i < sizeof(spectra) / sizeof(spectra[0]); i++) {
+    tables.insert(std::make_pair(spectra[i], NucWeightTable(spectra[i])));
+  }
+  return tables;
+}
 
-      double fiss = 0;
-      double absorb = 0;
-      if (absorb_xs.count(nuc) == 0) {
-        try {
-          fiss = simple_xs(nuc, "fission", "fission_spectrum_ave");
-          absorb = simple_xs(nuc, "absorption", "fission_spectrum_ave");
-          absorb_xs[nuc] = absorb;
-          fiss_xs[nuc] = fiss;
-        } catch (pyne::InvalidSimpleXS err) {
-          fiss = 0;
-          absorb = 0;
-        }
-      } else {
-        fiss = fiss_xs[nuc];
-        absorb = absorb_xs[nuc];
-      }
+const NucWeightTable& NucWeightTable::Get(std::string spectrum) {
+  // All tables are built together by a single thread the first time any of
+  // them is needed (function-local static initialization is thread-safe) and
+  // are never modified afterwards, so lookups need no locking.
+  static const std::map<std::string, NucWeightTable> tables =
+      BuildNucWeightTables();
+  std::map<std::string, NucWeightTable>::const_iterator it =
+      tables.find(spectrum);
+  if (it == tables.end()) {
+    throw cyclus::ValueError("cycamore::FuelFab - unsupported cross section "
+                             "spectrum '" + spectrum + "'");
+  }
+  return it->second;
+}
 
-      double p = nu * fiss - absorb;
-      w += it->second * (p - p_u238) / (p_pu239 - p_u238);
-    }
-    return w;
-  } else {
-    double nu_pu239 = 3.1;
-    double nu_u233 = 2.63;
-    double nu_u235 = 2.58;
-    double nu_u238 = 0;
-    double nu_pu241 = nu_pu239;
-
-    double fiss_u238 = simple_xs(922380000, "fission", spectrum);
-    double absorb_u238 = simple_xs(922380000, "absorption", spectrum);
-    double p_u238 = nu_u238 * fiss_u238 - absorb_u238;
-
-    double fiss_pu239 = simple_xs(942390000, "fission", spectrum);
-    double absorb_pu239 = simple_xs(942390000, "absorption", spectrum);
-    double p_pu239 = nu_pu239 * fiss_pu239 - absorb_pu239;
-
-    cyclus::CompMap::iterator it;
-    double w = 0;
-    for (it = cm.begin(); it != cm.end(); ++it) {
-      cyclus::Nuc nuc = it->first;
-      double nu = 0;
-      if (nuc == 922350000) {
-        nu = nu_u235;
-      } else if (nuc == 922330000) {
-        nu = nu_u233;
-      } else if (nuc == 942390000) {
-        nu = nu_pu239;
-      } else if (nuc == 942410000) {
-        nu = nu_pu241;
-      }
+double NucWeightTable::p(cyclus::Nuc nuc) const {
+  std::vector<cyclus::Nuc>::const_iterator it =
+      std::lower_bound(nucs_.begin(), nucs_.end(), nuc);
+  if (it != nucs_.end() && *it == nuc) {
+    return ps_[it - nucs_.begin()];
+  }
 
-      double fiss = 0;
-      double absorb = 0;
-      try {
-        fiss = simple_xs(nuc, "fission", spectrum);
-        absorb = simple_xs(nuc, "absorption", spectrum);
-      } catch (pyne::InvalidSimpleXS err) {
-        fiss = 0;
-        absorb = 0;
-      }
+  // Nuclides the table never probed (e.g. higher metastable states) are
+  // looked up directly, as CosiWeight always did.  These are rare enough in
+  // practice that the table is not grown to hold them.
+  try {
+    return CosiNu(nuc, spectrum_) * simple_xs(nuc, "fission", spectrum_) -
+           simple_xs(nuc, "absorption", spectrum_);
+  } catch (pyne::InvalidSimpleXS err) {
+    return 0;
+  }
+}
 
-      double p = nu * fiss - absorb;
-      w += it->second * (p - p_u238) / (p_pu239 - p_u238);
-    }
-    return w;
+const CosiWeightCache::Entry& CosiWeightCache::Get(Composition::Ptr c) {
+  std::map<int, Entry>::iterator it = entries_.find(c->id());
+  if (it != entries_.end()) {
+    return it->second;
   }
+  CompView v(c, xs_);
+  Entry& e = entries_[c->id()];
+  e.weight = v.Weight();
+  e.molar_mass = v.MolarMass();
+  return e;
 }
 
-// Convert an atom frac (n1/(n1+n2) to a mass frac (m1/(m1+m2) given
-// corresponding compositions c1 and c2.
-double AtomToMassFrac(double atomfrac, Composition::Ptr c1,
-                      Composition::Ptr c2) {
-  cyclus::CompMap n1 = c1->atom();
-  cyclus::CompMap n2 = c2->atom();
-  cyclus::compmath::Normalize(&n1, atomfrac);
-  cyclus::compmath::Normalize(&n2, 1 - atomfrac);
+double CosiWeightCache::AtomToMassFrac(double atomfrac, Composition::Ptr c1,
+                                       Composition::Ptr c2) {
+  double mass1 = atomfrac * MolarMass(c1);
+  double mass2 = (1 - atomfrac) * MolarMass(c2);
+  return mass1 / (mass1 + mass2);
+}
 
-  cyclus::CompMap::iterator it;
+double Dot(const double* a, const double* b, int n) {
+  double s0 = 0;
+  double s1 = 0;
+  double s2 = 0;
+  double s3 = 0;
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  for (; i < n; i++) {
+    s0 += a[i] * b[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
 
-  double mass1 = 0;
-  for (it = n1.begin(); it != n1.end(); ++it) {
-    mass1 += it->second * pyne::atomic_mass(it->first);
+CompView::CompView(Composition::Ptr c, const NucWeightTable* xs) {
+  const cyclus::CompMap& cm = c->atom();
+  nucs_.reserve(cm.size());
+  fracs_.reserve(cm.size());
+  masses_.reserve(cm.size());
+
+  double tot = 0;
+  cyclus::CompMap::const_iterator it;
+  for (it = cm.begin(); it != cm.end(); ++it) {
+    nucs_.push_back(it->first);
+    fracs_.push_back(it->second);
+    masses_.push_back(pyne::atomic_mass(it->first));
+    tot += it->second;
+  }
+  for (int i = 0; i < fracs_.size(); i++) {
+    fracs_[i] = tot == 0 ? 0 : fracs_[i] / tot;
   }
 
-  double mass2 = 0;
-  for (it = n2.begin(); it != n2.end(); ++it) {
-    mass2 += it->second * pyne::atomic_mass(it->first);
+  if (xs != NULL) {
+    weights_.reserve(cm.size());
+    for (int i = 0; i < nucs_.size(); i++) {
+      weights_.push_back(xs->w(nucs_[i]));
+    }
   }
+}
 
+// Convert an atom frac (n1/(n1+n2) to a mass frac (m1/(m1+m2) given
+// corresponding compositions c1 and c2.
+double AtomToMassFrac(double atomfrac, Composition::Ptr c1,
+                      Composition::Ptr c2) {
+  // m1 = atomfrac * M1 and m2 = (1 - atomfrac) * M2 where M is the mean atomic
+  // mass of each composition - no need to renormalize copies of either one.
+  double mass1 = atomfrac * CompView(c1).MolarMass();
+  double mass2 = (1 - atomfrac) * CompView(c2).MolarMass();
   return mass1 / (mass1 + mass2);
 }
 
@@ -9,6 +9,215 @@
 
 namespace cycamore {
 
+/// NucWeightTable holds the one group "p = nu*sigma_f - sigma_a" value for
+/// every nuclide with a known atomic mass (and its first metastable state) in
+/// PyNE's simple cross section library for a single spectrum, with p = 0 for
+/// nuclides without data.  Values are stored in a flat array sorted by nuclide
+/// id and looked up with a binary search.  Nuclides that were never probed
+/// fall back to a direct cross section lookup.
+/// Tables are immutable once built, so they can be read from several threads.
+class NucWeightTable {
+ public:
+  NucWeightTable(std::string spectrum);
+
+  /// Returns the shared table for spectrum.  The tables for all supported
+  /// spectra are built once on first use.
+  /// @throws ValueError for unsupported spectra
+  static const NucWeightTable& Get(std::string spectrum);
+
+  /// Returns p for nuc or zero if nuc has no cross section data.  Nuclides
+  /// that were never probed are looked up directly on each call.
+  double p(cyclus::Nuc nuc) const;
+
+  double p_u238() const { return p_u238_; }
+
+  double p_pu239() const { return p_pu239_; }
+
+  /// Returns the CosiWeight of pure nuc: (p - p_U238) / (p_Pu239 - p_U238).
+  double w(cyclus::Nuc nuc) const {
+    return (p(nuc) - p_u238_) / (p_pu239_ - p_u238_);
+  }
+
+  /// Returns the number of probed nuclides, including those without data.
+  int size() const { return nucs_.size(); }
+
+  const std::string& spectrum() const { return spectrum_; }
+
+ private:
+  std::string spectrum_;
+  std::vector<cyclus::Nuc> nucs_;
+  std::vector<double> ps_;
+  double p_u238_;
+  double p_pu239_;
+};
+
+/// Returns the dot product of the n element arrays a and b.  The loop keeps
+/// four independent partial sums so the compiler can vectorize it without
+/// being allowed to reorder floating point math; short arrays fall through to
+/// the scalar remainder loop.
+double Dot(const double* a, const double* b, int n);
+
+/// CompView is a flat structure-of-arrays view of a composition: nuclide ids
+/// and normalized atom fractions along with each nuclide's atomic mass and
+/// (optionally) CosiWeight looked up once up front.  Composition properties
+/// are then dot products over contiguous arrays instead of walks over the
+/// composition's map.
+class CompView {
+ public:
+  /// Builds the view of c.  Nuclide weights are only filled in if a cross
+  /// section table is given.
+  CompView(cyclus::Composition::Ptr c, const NucWeightTable* xs = NULL);
+
+  /// Returns the CosiWeight of the composition.  Only valid for views built
+  /// with a cross section table.
+  double Weight() const {
+    return weights_.empty() ? 0 : Dot(&fracs_[0], &weights_[0], size());
+  }
+
+  /// Returns the mean atomic mass (g/mol) of the composition.
+  double MolarMass() const {
+    return masses_.empty() ? 0 : Dot(&fracs_[0], &masses_[0], size());
+  }
+
+  /// Returns the number of nuclides in the composition.
+  int size() const { return nucs_.size(); }
+
+  const std::vector<cyclus::Nuc>& nucs() const { return nucs_; }
+
+  const std::vector<double>& fracs() const { return fracs_; }
+
+ private:
+  std::vector<cyclus::Nuc> nucs_;
+  std::vector<double> fracs_;
+  std::vector<double> masses_;
+  std::vector<double> weights_;
+};
+
+/// CosiWeightCache memoizes CosiWeight results and mean atomic masses for a
+/// single table.  Entries are keyed on composition id - compositions are
+/// immutable and their ids are never reused, so an entry can never go stale.
+/// A FuelFab shares its cache with the converters it hands to the exchange and
+/// clears it every time step so one-off offer compositions don't accumulate.
+class CosiWeightCache {
+ public:
+  typedef boost::shared_ptr<CosiWeightCache> Ptr;
+
+  CosiWeightCache(const NucWeightTable& xs) : xs_(&xs) {}
+
+  /// Returns the CosiWeight of c - only computing it on the first lookup.
+  double Weight(cyclus::Composition::Ptr c) { return Get(c).weight; }
+
+  /// Returns the mean atomic mass of c - only computing it on the first
+  /// lookup.
+  double MolarMass(cyclus::Composition::Ptr c) { return Get(c).molar_mass; }
+
+  /// Same as the free AtomToMassFrac function, but uses the cached mean
+  /// atomic masses of c1 and c2.
+  double AtomToMassFrac(double atomfrac, cyclus::Composition::Ptr c1,
+                        cyclus::Composition::Ptr c2);
+
+  /// Drops all cached entries.
+  void Clear() { entries_.clear(); }
+
+  /// Returns the number of cached compositions.
+  int size() const { return entries_.size(); }
+
+  const NucWeightTable& xs() const { return *xs_; }
+
+ private:
+  struct Entry {
+    double weight;
+    double molar_mass;
+  };
+
+  const Entry& Get(cyclus::Composition::Ptr c);
+
+  const NucWeightTable* xs_;
+  std::map<int, Entry> entries_;
+};
+
+/// MixConverter is the common base of the converters for the three FuelFab
+/// inventories.  Each converter maps a requested material to the mass of its
+/// inventory needed per unit of requested material.  That ratio only depends
+/// on the requested composition, so it is memoized by composition id - the
+/// exchange translator calls convert once per arc per constraint, and most
+/// arcs share a few target recipes.
+class MixConverter : public cyclus::Converter<cyclus::Material> {
+ public:
+  MixConverter(cyclus::Composition::Ptr c_fill,
+               cyclus::Composition::Ptr c_fiss,
+               cyclus::Composition::Ptr c_topup, CosiWeightCache::Ptr weights);
+
+  virtual ~MixConverter() {}
+
+  virtual double convert(
+      cyclus::Material::Ptr m, cyclus::Arc const* a = NULL,
+      cyclus::ExchangeTranslationContext<cyclus::Material> const* ctx =
+          NULL) const;
+
+  /// @returns true if other is the same kind of converter for the same
+  /// inventory compositions and cross section table
+  virtual bool operator==(Converter& other) const;
+
+ protected:
+  /// Returns the mass of this converter's inventory needed per unit mass of
+  /// material with weight w_tgt or CY_LARGE_DOUBLE if it can't be made.
+  virtual double Ratio(double w_tgt) const = 0;
+
+  CosiWeightCache::Ptr weights_;
+  double w_fiss_;
+  double w_topup_;
+  double w_fill_;
+  cyclus::Composition::Ptr c_fiss_;
+  cyclus::Composition::Ptr c_fill_;
+  cyclus::Composition::Ptr c_topup_;
+
+ private:
+  mutable std::map<int, double> ratios_;
+};
+
+/// Converter for the fissile inventory.
+class FissConverter : public MixConverter {
+ public:
+  FissConverter(cyclus::Composition::Ptr c_fill,
+                cyclus::Composition::Ptr c_fiss,
+                cyclus::Composition::Ptr c_topup, CosiWeightCache::Ptr weights)
+      : MixConverter(c_fill, c_fiss, c_topup, weights) {}
+
+  virtual ~FissConverter() {}
+
+ protected:
+  virtual double Ratio(double w_tgt) const;
+};
+
+/// Converter for the filler inventory.
+class FillConverter : public MixConverter {
+ public:
+  FillConverter(cyclus::Composition::Ptr c_fill,
+                cyclus::Composition::Ptr c_fiss,
+                cyclus::Composition::Ptr c_topup, CosiWeightCache::Ptr weights)
+      : MixConverter(c_fill, c_fiss, c_topup, weights) {}
+
+  virtual ~FillConverter() {}
+
+ protected:
+  virtual double Ratio(double w_tgt) const;
+};
+
+/// Converter for the topup inventory.
+class TopupConverter : public MixConverter {
+ public:
+  TopupConverter(cyclus::Composition::Ptr c_fill,
+                 cyclus::Composition::Ptr c_fiss,
+                 cyclus::Composition::Ptr c_topup, CosiWeightCache::Ptr weights)
+      : MixConverter(c_fill, c_fiss, c_topup, weights) {}
+
+  virtual ~TopupConverter() {}
+
+ protected:
+  virtual double Ratio(double w_tgt) const;
+};
+
 /// FuelFab takes in 2 streams of material and mixes them in ratios in order to
 /// supply material that matches some neutronics properties of reqeusted
 /// material.  It uses an equivalence type method [1]
@@ -114,7 +323,7 @@ class FuelFab
 
 #pragma cyclus
 
-  virtual void Tick(){};
+  virtual void Tick();
   virtual void Tock(){};
   virtual void EnterNotify();
 
@@ -133,6 +342,14 @@ class FuelFab
   GetMatlRequests();
 
  private:
+  /// Returns the composition of the fill/fiss (or fiss/topup) mixture that
+  /// matches the weight of tgt, or a null pointer if the streams can't span
+  /// it.  Topup is only considered if there is topup inventory on hand.
+  cyclus::Composition::Ptr MixOffer(cyclus::Composition::Ptr tgt,
+                                    cyclus::Composition::Ptr c_fill,
+                                    cyclus::Composition::Ptr c_fiss,
+                                    cyclus::Composition::Ptr c_topup);
+
   // Code Injection:
   #include "toolkit/position.cycpp.h"
 
@@ -268,9 +485,13 @@ class FuelFab
   // map<request, inventory name>
   std::map<cyclus::Request<cyclus::Material>*, std::string> req_inventories_;
 
+  // weights of inventory, target and offer compositions - cleared every tick.
+  CosiWeightCache::Ptr weights_;
+
 };
 
 double CosiWeight(cyclus::Composition::Ptr c, const std::string& spectrum);
+double CosiWeight(cyclus::Composition::Ptr c, const NucWeightTable& xs);
 bool ValidWeights(double w_low, double w_tgt, double w_high);
 double LowFrac(double w_low, double w_tgt, double w_high, double eps = cyclus::CY_NEAR_ZERO);
 double HighFrac(double w_low, double w_tgt, double w_high, double eps = cyclus::CY_NEAR_ZERO);
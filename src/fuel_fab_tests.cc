@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 #include <sstream>
+#include <thread>
 #include "cyclus.h"
 
 using pyne::nucname::id;
@@ -140,6 +141,231 @@ TEST(FuelFabTests, CosiWeight_Mixed) {
   EXPECT_LT(std::abs((w_target-got)/w_target), 0.00001) << "mixed composition not within 0.001% of target";
 }
 
+// the flat cross section table must agree with direct simple_xs lookups and
+// be built only once per spectrum.
+TEST(FuelFabTests, NucWeightTable) {
+  cyclus::Env::SetNucDataPath();
+  std::string spec = "resonance_integral";
+  const NucWeightTable& xs = NucWeightTable::Get(spec);
+  EXPECT_EQ(&xs, &NucWeightTable::Get(spec));
+  EXPECT_GT(xs.size(), 0);
+
+  double p_pu241 = 3.1 * pyne::simple_xs(942410000, "fission", spec) -
+                   pyne::simple_xs(942410000, "absorption", spec);
+  double p_u235 = 2.58 * pyne::simple_xs(922350000, "fission", spec) -
+                  pyne::simple_xs(922350000, "absorption", spec);
+  EXPECT_DOUBLE_EQ(p_pu241, xs.p(942410000));
+  EXPECT_DOUBLE_EQ(p_u235, xs.p(922350000));
+
+  CompMap m;
+  m[942390000] = 1;
+  EXPECT_DOUBLE_EQ(1.0, CosiWeight(Composition::CreateFromMass(m), spec));
+  m.clear();
+  m[922380000] = 1;
+  EXPECT_DOUBLE_EQ(0.0, CosiWeight(Composition::CreateFromMass(m), spec));
+}
+
+// Computes weights of all comps for all specs many times over, leaving the
+// results of the last pass in w.
+void CosiWeights(std::vector<Composition::Ptr> comps,
+                 std::vector<std::string> specs, std::vector<double>* w) {
+  for (int n = 0; n < 50; n++) {
+    w->clear();
+    for (int i = 0; i < specs.size(); i++) {
+      for (int j = 0; j < comps.size(); j++) {
+        w->push_back(CosiWeight(comps[j], specs[i]));
+      }
+    }
+  }
+}
+
+// CosiWeight only reads from the shared cross section tables, so evaluating it
+// from several threads at once must give the same results as a single thread.
+TEST(FuelFabTests, CosiWeightThreaded) {
+  cyclus::Env::SetNucDataPath();
+  std::vector<Composition::Ptr> comps;
+  comps.push_back(c_uox());
+  comps.push_back(c_mox());
+  comps.push_back(c_natu());
+  comps.push_back(c_pustream());
+  comps.push_back(c_pustreamlow());
+  comps.push_back(c_pustreambad());
+  comps.push_back(c_water());
+  std::vector<std::string> specs;
+  specs.push_back("thermal");
+  specs.push_back("fission_spectrum_ave");
+  specs.push_back("resonance_integral");
+  specs.push_back("fourteen_MeV");
+
+  // the single threaded pass also fills in each composition's lazily computed
+  // atom fractions, which are not ours to make thread-safe.
+  std::vector<double> want;
+  CosiWeights(comps, specs, &want);
+
+  int nthreads = 8;
+  std::vector<std::vector<double> > got(nthreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nthreads; i++) {
+    threads.push_back(std::thread(CosiWeights, comps, specs, &got[i]));
+  }
+  for (int i = 0; i < nthreads; i++) {
+    threads[i].join();
+  }
+
+  for (int i = 0; i < nthreads; i++) {
+    ASSERT_EQ(want.size(), got[i].size());
+    for (int j = 0; j < want.size(); j++) {
+      EXPECT_EQ(want[j], got[i][j]) << "thread " << i << ", weight " << j;
+    }
+  }
+}
+
+// cached weights must match uncached ones and repeated lookups of the same
+// composition must not add new entries.
+TEST(FuelFabTests, CosiWeightCache) {
+  cyclus::Env::SetNucDataPath();
+  Composition::Ptr mox = c_mox();
+  Composition::Ptr uox = c_uox();
+  CosiWeightCache cache(NucWeightTable::Get("thermal"));
+
+  EXPECT_DOUBLE_EQ(CosiWeight(mox, "thermal"), cache.Weight(mox));
+  EXPECT_DOUBLE_EQ(CosiWeight(uox, "thermal"), cache.Weight(uox));
+  EXPECT_EQ(2, cache.size());
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_DOUBLE_EQ(CosiWeight(mox, "thermal"), cache.Weight(mox));
+  }
+  EXPECT_EQ(2, cache.size());
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_DOUBLE_EQ(CosiWeight(uox, "thermal"), cache.Weight(uox));
+}
+
+// converters must reuse their memoized ratios for repeated target
+// compositions and only compare equal to converters of the same kind built
+// from the same inventories.
+TEST(FuelFabTests, MixConverter) {
+  cyclus::Env::SetNucDataPath();
+  Composition::Ptr natu = c_natu();
+  Composition::Ptr pu = c_pustream();
+  Composition::Ptr water = c_water();
+  CosiWeightCache::Ptr cache(
+      new CosiWeightCache(NucWeightTable::Get("thermal")));
+
+  FissConverter fiss(natu, pu, water, cache);
+  FillConverter fill(natu, pu, water, cache);
+  Material::Ptr m = Material::CreateUntracked(2, c_uox());
+
+  double w_fill = CosiWeight(natu, "thermal");
+  double w_fiss = CosiWeight(pu, "thermal");
+  double w_tgt = CosiWeight(m->comp(), "thermal");
+  double frac = AtomToMassFrac(HighFrac(w_fill, w_tgt, w_fiss), pu, natu);
+  double want = fiss.convert(m);
+  EXPECT_NEAR(2 * frac, want, 1e-12);
+
+  // with the weight cache emptied, a second convert of the same composition
+  // must come from the memo and not look the weight up again.
+  cache->Clear();
+  for (int i = 0; i < 10; i++) {
+    EXPECT_DOUBLE_EQ(want, fiss.convert(m));
+  }
+  EXPECT_EQ(0, cache->size());
+
+  FissConverter fiss2(natu, pu, water, cache);
+  EXPECT_TRUE(fiss == fiss2);
+  EXPECT_TRUE(fiss2 == fiss);
+  EXPECT_FALSE(fiss == fill);
+  EXPECT_FALSE(fill == fiss);
+
+  FissConverter other(natu, c_pustreamlow(), water, cache);
+  EXPECT_FALSE(fiss == other);
+}
+
+// a spent-MOX-like composition with a few dozen nuclides
+Composition::Ptr c_spentmox() {
+  const char* nucs[] = {"u234", "u235", "u236", "u238", "np237", "pu238",
+                        "pu239", "pu240", "pu241", "pu242", "am241", "am242m",
+                        "am243", "cm242", "cm243", "cm244", "cm245", "cs133",
+                        "cs134", "cs135", "cs137", "sr90", "tc99", "i129",
+                        "nd143", "nd145", "sm149", "sm151", "eu155", "gd155",
+                        "xe131", "xe135", "rh103", "ru101", "o16"};
+  CompMap m;
+  for (int i = 0; i < sizeof(nucs) / sizeof(nucs[0]); i++) {
+    m[id(nucs[i])] = 1.0 / (i + 1);
+  }
+  return Composition::CreateFromAtom(m);
+}
+
+// The previous map based implementations CompView replaced.
+double MapCosiWeight(Composition::Ptr c, const NucWeightTable& xs) {
+  CompMap cm = c->atom();
+  cyclus::compmath::Normalize(&cm);
+  double w = 0;
+  for (CompMap::iterator it = cm.begin(); it != cm.end(); ++it) {
+    double p = xs.p(it->first);
+    w += it->second * (p - xs.p_u238()) / (xs.p_pu239() - xs.p_u238());
+  }
+  return w;
+}
+
+double MapAtomToMassFrac(double atomfrac, Composition::Ptr c1,
+                         Composition::Ptr c2) {
+  CompMap n1 = c1->atom();
+  CompMap n2 = c2->atom();
+  cyclus::compmath::Normalize(&n1, atomfrac);
+  cyclus::compmath::Normalize(&n2, 1 - atomfrac);
+  double mass1 = 0;
+  for (CompMap::iterator it = n1.begin(); it != n1.end(); ++it) {
+    mass1 += it->second * pyne::atomic_mass(it->first);
+  }
+  double mass2 = 0;
+  for (CompMap::iterator it = n2.begin(); it != n2.end(); ++it) {
+    mass2 += it->second * pyne::atomic_mass(it->first);
+  }
+  return mass1 / (mass1 + mass2);
+}
+
+TEST(FuelFabTests, Dot) {
+  double a[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  double b[9] = {.5, -1, 2, .25, 3, -2, 1, 4, .125};
+  double want = 0;
+  EXPECT_DOUBLE_EQ(0, Dot(a, b, 0));
+  for (int n = 1; n <= 9; n++) {
+    want += a[n - 1] * b[n - 1];
+    EXPECT_DOUBLE_EQ(want, Dot(a, b, n)) << "n=" << n;
+  }
+}
+
+// the flat array kernels must stay within 1e-12 of the map based code.
+TEST(FuelFabTests, CompView) {
+  cyclus::Env::SetNucDataPath();
+  double tol = 1e-12;
+  const NucWeightTable& xs = NucWeightTable::Get("thermal");
+  Composition::Ptr comps[] = {c_spentmox(), c_mox(), c_uox(), c_natu(),
+                              c_pustream(), c_water()};
+  int ncomps = sizeof(comps) / sizeof(comps[0]);
+
+  CompView v(comps[0], &xs);
+  EXPECT_EQ(comps[0]->atom().size(), v.size());
+  EXPECT_LT(30, v.size());
+
+  CosiWeightCache cache(xs);
+  for (int i = 0; i < ncomps; i++) {
+    EXPECT_NEAR(MapCosiWeight(comps[i], xs), CompView(comps[i], &xs).Weight(),
+                tol);
+    EXPECT_NEAR(MapCosiWeight(comps[i], xs), cache.Weight(comps[i]), tol);
+    for (int j = 0; j < ncomps; j++) {
+      for (double f = 0; f <= 1; f += 0.125) {
+        double want = MapAtomToMassFrac(f, comps[i], comps[j]);
+        EXPECT_NEAR(want, AtomToMassFrac(f, comps[i], comps[j]), tol);
+        EXPECT_NEAR(want, cache.AtomToMassFrac(f, comps[i], comps[j]), tol);
+      }
+    }
+  }
+  EXPECT_EQ(ncomps, cache.size());
+}
+
 TEST(FuelFabTests, HighFrac) {
   cyclus::Env::SetNucDataPath();
   double w_fill = CosiWeight(c_natu(), "thermal");
@@ -585,6 +811,61 @@ TEST(FuelFabTests, FillConstrained) {
   EXPECT_NEAR(max_provide, m->quantity(), cyclus::CY_NEAR_ZERO) << "matched trade uses more fill than available";
 }
 
+// requests sharing target recipes reuse one mixed offer per recipe - every
+// request must still get its own quantity at the right weight.
+TEST(FuelFabTests, RepeatedTargetRecipes) {
+  cyclus::Env::SetNucDataPath();
+  std::string config =
+     "<fill_commods> <val>natu</val> </fill_commods>"
+     "<fill_recipe>natu</fill_recipe>"
+     "<fill_size>1000</fill_size>"
+     ""
+     "<fiss_commods> <val>pustream</val> </fiss_commods>"
+     "<fiss_recipe>pustream</fiss_recipe>"
+     "<fiss_size>1000</fiss_size>"
+     ""
+     "<outcommod>recyclefuel</outcommod>"
+     "<spectrum>thermal</spectrum>"
+     "<throughput>1000</throughput>"
+     ;
+  int simdur = 2;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:FuelFab"), config, simdur);
+  sim.AddSource("pustream").Finalize();
+  sim.AddSource("natu").Finalize();
+  sim.AddSink("recyclefuel").recipe("uox").capacity(1).Finalize();
+  sim.AddSink("recyclefuel").recipe("uox").capacity(2).Finalize();
+  sim.AddSink("recyclefuel").recipe("uox").capacity(3).Finalize();
+  sim.AddSink("recyclefuel").recipe("mox").capacity(4).Finalize();
+  sim.AddSink("recyclefuel").recipe("mox").capacity(5).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("mox", c_mox());
+  sim.AddRecipe("pustream", c_pustream());
+  sim.AddRecipe("natu", c_natu());
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("recyclefuel")));
+  conds.push_back(Cond("Time", "==", 1));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(5, qr.rows.size());
+
+  double w_uox = CosiWeight(c_uox(), "thermal");
+  double w_mox = CosiWeight(c_mox(), "thermal");
+  double tot = 0;
+  int nuox = 0;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+    double w = CosiWeight(m->comp(), "thermal");
+    double w_target = m->quantity() < 3.5 ? w_uox : w_mox;
+    nuox += m->quantity() < 3.5 ? 1 : 0;
+    EXPECT_LT(std::abs((w_target - w) / w_target), 0.00001)
+        << "mixed composition not within 0.001% of target";
+    tot += m->quantity();
+  }
+  EXPECT_EQ(3, nuox);
+  EXPECT_NEAR(15, tot, 1e-6);
+}
+
 // fuel is requested requiring more fissile material than is available with
 // plenty of filler.
 TEST(FuelFabTests, FissConstrained) {
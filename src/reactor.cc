@@ -21,7 +21,18 @@ Reactor::Reactor(cyclus::Context* ctx)
       power_cap(0),
       power_name("power"),
       discharged(false),
-      keep_packaging(true) {}
+      keep_packaging(true),
+      batch_requests(false),
+      batch_sent(false),
+      batch_fallback(false),
+      interval_output(false),
+      interval_start(-1),
+      interval_end(-1),
+      interval_producing(false),
+      legacy_event_output(false),
+      sliced_bids(false),
+      spent_indexed_(false),
+      core_ordered_(false) {}
 
 
 #pragma cyclus def clone cycamore::Reactor
@@ -32,7 +43,11 @@ Reactor::Reactor(cyclus::Context* ctx)
 
 #pragma cyclus def infiletodb cycamore::Reactor
 
-#pragma cyclus def snapshot cycamore::Reactor
+void Reactor::Snapshot(cyclus::DbInit di) {
+  res_index_map_.ToMap(&res_indexes);
+  #pragma cyclus impl snapshot cycamore::Reactor
+  res_indexes.clear();
+}
 
 #pragma cyclus def snapshotinv cycamore::Reactor
 
@@ -40,11 +55,14 @@ Reactor::Reactor(cyclus::Context* ctx)
 
 void Reactor::InitFrom(Reactor* m) {
   #pragma cyclus impl initfromcopy cycamore::Reactor
+  res_index_map_ = m->res_index_map_;
   cyclus::toolkit::CommodityProducer::Copy(m);
 }
 
 void Reactor::InitFrom(cyclus::QueryableBackend* b) {
   #pragma cyclus impl initfromdb cycamore::Reactor
+  res_index_map_.FromMap(res_indexes);
+  res_indexes.clear();
 
   namespace tk = cyclus::toolkit;
   tk::CommodityProducer::Add(tk::Commodity(power_name),
@@ -138,6 +156,11 @@ bool Reactor::CheckDecommissionCondition() {
   return core.count() == 0 && spent.count() == 0;
 }
 
+void Reactor::Decommission() {
+  FlushInterval();
+  cyclus::Facility::Decommission();
+}
+
 void Reactor::Tick() {
   // The following code must go in the Tick so they fire on the time step
   // following the cycle_step update - allowing for the all reactor events to
@@ -146,7 +169,7 @@ void Reactor::Tick() {
   // can't go at the beginnin of the Tock is so that resource exchange has a
   // chance to occur after the discharge on this same time step.
   if (retired()) {
-    Record("RETIRED", "");
+    Record(kEventRetired);
 
     if (context()->time() == exit_time() + 1) { // only need to transmute once
       if (decom_transmute_all == true) {
@@ -165,7 +188,7 @@ void Reactor::Tick() {
     // burn a batch from fresh inventory on this time step.  When retired,
     // this batch also needs to be discharged to spent fuel inventory.
     while (fresh.count() > 0 && spent.space() >= assem_size) {
-      spent.Push(fresh.Pop());
+      PushSpent(MatVec(1, fresh.Pop()));
     }
     if(CheckDecommissionCondition()) {
       context()->SchedDecom(this);    
@@ -175,7 +198,7 @@ void Reactor::Tick() {
 
   if (cycle_step == cycle_time) {
     Transmute();
-    Record("CYCLE_END", "");
+    Record(kEventCycleEnd);
   }
 
   if (cycle_step >= cycle_time && !discharged) {
@@ -188,12 +211,8 @@ void Reactor::Tick() {
   int t = context()->time();
 
   // update preferences
-  for (int i = 0; i < pref_change_times.size(); i++) {
-    int change_t = pref_change_times[i];
-    if (t != change_t) {
-      continue;
-    }
-
+  int i;
+  while ((i = NextChange(pref_change_times, &pref_change_queue_, t)) >= 0) {
     std::string incommod = pref_change_commods[i];
     for (int j = 0; j < fuel_incommods.size(); j++) {
       if (fuel_incommods[j] == incommod) {
@@ -204,28 +223,48 @@ void Reactor::Tick() {
   }
 
   // update recipes
-  for (int i = 0; i < recipe_change_times.size(); i++) {
-    int change_t = recipe_change_times[i];
-    if (t != change_t) {
-      continue;
-    }
-
+  while ((i = NextChange(recipe_change_times, &recipe_change_queue_, t)) >= 0) {
     std::string incommod = recipe_change_commods[i];
     for (int j = 0; j < fuel_incommods.size(); j++) {
       if (fuel_incommods[j] == incommod) {
         fuel_inrecipes[j] = recipe_change_in[i];
         fuel_outrecipes[j] = recipe_change_out[i];
+        incomps_.clear();
         break;
       }
     }
   }
 }
 
+int Reactor::NextChange(const std::vector<int>& times, ChangeQueue* q, int t) {
+  if (q->order.size() != times.size()) {
+    // first use (or restart) - sort changes by time, keeping the input order
+    // for changes on the same time step, and skip any that already passed.
+    std::vector<std::pair<int, int> > sorted;
+    for (int i = 0; i < times.size(); i++) {
+      sorted.push_back(std::make_pair(times[i], i));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    q->order.clear();
+    for (int i = 0; i < sorted.size(); i++) {
+      q->order.push_back(sorted[i].second);
+    }
+    q->next = 0;
+  }
+
+  while (q->next < q->order.size() && times[q->order[q->next]] < t) {
+    q->next++;
+  }
+  if (q->next < q->order.size() && times[q->order[q->next]] == t) {
+    return q->order[q->next++];
+  }
+  return -1;
+}
+
 std::set<cyclus::RequestPortfolio<Material>::Ptr> Reactor::GetMatlRequests() {
   using cyclus::RequestPortfolio;
 
   std::set<RequestPortfolio<Material>::Ptr> ports;
-  Material::Ptr m;
 
   // second min expression reduces assembles to amount needed until
   // retirement if it is near.
@@ -243,29 +282,65 @@ std::set<cyclus::RequestPortfolio<Material>::Ptr> Reactor::GetMatlRequests() {
     n_assem_order = std::min(n_assem_order, n_need);
   }
 
+  if (batch_sent) {
+    // the last batch request was never filled
+    batch_sent = false;
+    batch_fallback = true;
+  }
+
   if (n_assem_order == 0) {
+    batch_fallback = false;
     return ports;
   } else if (retired()) {
     return ports;
   }
 
+  // every assembly is requested with the same set of fuels, so build one
+  // template material per fuel and share it between the portfolios.
+  std::vector<Material::Ptr> mats;
+  for (int j = 0; j < fuel_incommods.size(); j++) {
+    mats.push_back(Material::CreateUntracked(assem_size, fuel_incomp(j)));
+  }
+
+  std::vector<double>::iterator result;
+  result = std::max_element(fuel_prefs.begin(), fuel_prefs.end());
+  int max_index = std::distance(fuel_prefs.begin(), result);
+
+  if (batch_requests && !batch_fallback) {
+    // a single all-or-nothing request per fuel for the whole order - received
+    // material is split back into assemblies in AcceptMatlTrades.  If no
+    // supplier can fill it, the next time step falls back to per-assembly
+    // requests.
+    batch_sent = true;
+    RequestPortfolio<Material>::Ptr port(new RequestPortfolio<Material>());
+    std::vector<Request<Material>*> mreqs;
+    for (int j = 0; j < fuel_incommods.size(); j++) {
+      Material::Ptr m = Material::CreateUntracked(n_assem_order * assem_size,
+                                                  mats[j]->comp());
+      Request<Material>* r = port->AddRequest(m, this, fuel_incommods[j],
+                                              fuel_prefs[j], true);
+      mreqs.push_back(r);
+    }
+    for (int i = 0; i < n_assem_order; i++) {
+      cyclus::toolkit::RecordTimeSeries<double>("demand"+fuel_incommods[max_index], this,
+                                            assem_size) ;
+    }
+    port->AddMutualReqs(mreqs);
+    ports.insert(port);
+    return ports;
+  }
+
   for (int i = 0; i < n_assem_order; i++) {
     RequestPortfolio<Material>::Ptr port(new RequestPortfolio<Material>());
     std::vector<Request<Material>*> mreqs;
     for (int j = 0; j < fuel_incommods.size(); j++) {
       std::string commod = fuel_incommods[j];
       double pref = fuel_prefs[j];
-      cyclus::Composition::Ptr recipe = context()->GetRecipe(fuel_inrecipes[j]);
-      m = Material::CreateUntracked(assem_size, recipe);
-
-      Request<Material>* r = port->AddRequest(m, this, commod, pref, true);
+      Request<Material>* r = port->AddRequest(mats[j], this, commod, pref,
+                                              true);
       mreqs.push_back(r);
     }
 
-    std::vector<double>::iterator result;
-    result = std::max_element(fuel_prefs.begin(), fuel_prefs.end());
-    int max_index = std::distance(fuel_prefs.begin(), result);
-
     cyclus::toolkit::RecordTimeSeries<double>("demand"+fuel_incommods[max_index], this,
                                           assem_size) ;
 
@@ -282,40 +357,56 @@ void Reactor::GetMatlTrades(
         responses) {
   using cyclus::Trade;
 
-  std::map<std::string, MatVec> mats = PopSpent();
+  std::map<std::string, std::deque<Material::Ptr> >& mats = SpentIndex();
+  std::map<std::string, int> ntraded;
+  std::set<int> traded;
   for (int i = 0; i < trades.size(); i++) {
+    // trade away oldest assemblies first
     std::string commod = trades[i].request->commodity();
-    Material::Ptr m = mats[commod].back();
-    mats[commod].pop_back();
+    Material::Ptr m = mats[commod][ntraded[commod]++];
     responses.push_back(std::make_pair(trades[i], m));
-    res_indexes.erase(m->obj_id());
+    traded.insert(m->obj_id());
   }
-  PushSpent(mats);  // return leftovers back to spent buffer
+  PopSpent(traded);
 }
 
 void Reactor::AcceptMatlTrades(const std::vector<
     std::pair<cyclus::Trade<Material>, Material::Ptr> >& responses) {
   std::vector<std::pair<cyclus::Trade<Material>,
                         Material::Ptr> >::const_iterator trade;
+  batch_sent = false;
 
-  std::stringstream ss;
-  int nload = std::min((int)responses.size(), n_assem_core - core.count());
-  if (nload > 0) {
-    ss << nload << " assemblies";
-    Record("LOAD", ss.str());
-  }
-
+  // split batched requests back into individual assemblies
+  std::vector<std::pair<std::string, Material::Ptr> > assems;
   for (trade = responses.begin(); trade != responses.end(); ++trade) {
     std::string commod = trade->first.request->commodity();
     Material::Ptr m = trade->second;
+    while (batch_requests && m->quantity() > assem_size + cyclus::eps_rsrc()) {
+      assems.push_back(std::make_pair(commod, m->ExtractQty(assem_size)));
+    }
+    assems.push_back(std::make_pair(commod, m));
+  }
+
+  int nload = std::min((int)assems.size(), n_assem_core - core.count());
+  if (nload > 0) {
+    Record(kEventLoad, nload);
+  }
+
+  for (int i = 0; i < assems.size(); i++) {
+    std::string commod = assems[i].first;
+    Material::Ptr m = assems[i].second;
     index_res(m, commod);
 
     if (core.count() < n_assem_core) {
-      core.Push(m);
+      PushCore(MatVec(1, m));
     } else {
       fresh.Push(m);
     }
   }
+
+  if (core.count() == n_assem_core && fresh.count() == n_assem_fresh) {
+    batch_fallback = false;  // order filled - batch the next one again
+  }
 }
 
 std::set<cyclus::BidPortfolio<Material>::Ptr> Reactor::GetMatlBids(
@@ -323,9 +414,6 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Reactor::GetMatlBids(
   using cyclus::BidPortfolio;
   std::set<BidPortfolio<Material>::Ptr> ports;
 
-  bool gotmats = false;
-  std::map<std::string, MatVec> all_mats;
-
   if (uniq_outcommods_.empty()) {
     for (int i = 0; i < fuel_outcommods.size(); i++) {
       uniq_outcommods_.insert(fuel_outcommods[i]);
@@ -338,28 +426,46 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Reactor::GetMatlBids(
     std::vector<Request<Material>*>& reqs = commod_requests[commod];
     if (reqs.size() == 0) {
       continue;
-    } else if (!gotmats) {
-      all_mats = PeekSpent();
     }
 
-    MatVec mats = all_mats[commod];
+    const std::deque<Material::Ptr>& mats = SpentIndex()[commod];
     if (mats.size() == 0) {
       continue;
     }
 
     BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
 
+    // With sliced bids, each request is bid the next run of assemblies
+    // (oldest first) that covers it rather than a run starting at the oldest
+    // assembly, so every assembly is bid at most once.  This is only done
+    // when the spent fuel covers every request - otherwise each request is
+    // bid from the oldest assembly so that none of them goes without bids.
+    bool slice = sliced_bids;
+    if (slice) {
+      double tot_req = 0;
+      for (int j = 0; j < reqs.size(); j++) {
+        tot_req += reqs[j]->target()->quantity();
+      }
+      slice = SpentQty(commod) >= tot_req;
+    }
+
+    int next = 0;
     for (int j = 0; j < reqs.size(); j++) {
       Request<Material>* req = reqs[j];
       double tot_bid = 0;
-      for (int k = 0; k < mats.size(); k++) {
-        Material::Ptr m = mats[k];
+      int k = slice ? next : 0;
+      while (k < mats.size()) {
+        Material::Ptr m = mats[k++];
         tot_bid += m->quantity();
         port->AddBid(req, m, this, true);
         if (tot_bid >= req->target()->quantity()) {
           break;
         }
       }
+      next = k;
+      if (slice && next == mats.size()) {
+        break;  // every assembly has been bid
+      }
     }
 
     double tot_qty = 0;
@@ -377,6 +483,7 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Reactor::GetMatlBids(
 
 void Reactor::Tock() {
   if (retired()) {
+    FlushInterval();
     return;
   }
   
@@ -389,18 +496,21 @@ void Reactor::Tock() {
   }
 
   if (cycle_step == 0 && core.count() == n_assem_core) {
-    Record("CYCLE_START", "");
+    Record(kEventCycleStart);
   }
 
-  if (cycle_step >= 0 && cycle_step < cycle_time &&
-      core.count() == n_assem_core) {
-    cyclus::toolkit::RecordTimeSeries<cyclus::toolkit::POWER>(this, power_cap);
-    cyclus::toolkit::RecordTimeSeries<double>("supplyPOWER", this, power_cap);
-    RecordSideProduct(true);
+  bool producing = cycle_step >= 0 && cycle_step < cycle_time &&
+                   core.count() == n_assem_core;
+  double power = producing ? power_cap : 0;
+  if (interval_output) {
+    // listeners still hear about every time step - only the rows are batched
+    NotifyTimeSeries("Power", power);
+    NotifyTimeSeries("supplyPOWER", power);
+    RecordInterval(producing);
   } else {
-    cyclus::toolkit::RecordTimeSeries<cyclus::toolkit::POWER>(this, 0);
-    cyclus::toolkit::RecordTimeSeries<double>("supplyPOWER", this, 0);
-    RecordSideProduct(false);
+    cyclus::toolkit::RecordTimeSeries<cyclus::toolkit::POWER>(this, power);
+    cyclus::toolkit::RecordTimeSeries<double>("supplyPOWER", this, power);
+    RecordSideProduct(producing);
   }
 
   // "if" prevents starting cycle after initial deployment until core is full
@@ -413,54 +523,39 @@ void Reactor::Tock() {
 void Reactor::Transmute() { Transmute(n_assem_batch); }
 
 void Reactor::Transmute(int n_assem) {
-  MatVec old = core.PopN(std::min(n_assem, core.count()));
-  core.Push(old);
-  if (core.count() > old.size()) {
-    // rotate untransmuted mats back to back of buffer
-    core.Push(core.PopN(core.count() - old.size()));
-  }
-
-  std::stringstream ss;
-  ss << old.size() << " assemblies";
-  Record("TRANSMUTE", ss.str());
-
-  for (int i = 0; i < old.size(); i++) {
-    old[i]->Transmute(context()->GetRecipe(fuel_outrecipe(old[i])));
-  }
-}
-
-std::map<std::string, MatVec> Reactor::PeekSpent() {
-  std::map<std::string, MatVec> mapped;
-  MatVec mats = spent.PopN(spent.count());
-  spent.Push(mats);
-  for (int i = 0; i < mats.size(); i++) {
-    std::string commod = fuel_outcommod(mats[i]);
-    mapped[commod].push_back(mats[i]);
+  // read the oldest n_assem assemblies from the core order mirror - the core
+  // buffer itself is not touched and the assemblies stay at its front.
+  std::deque<Material::Ptr>& mats = CoreOrder();
+  int n = std::min(n_assem, static_cast<int>(mats.size()));
+
+  Record(kEventTransmute, n);
+
+  // assemblies of the same fuel share an outrecipe - only resolve it once.
+  std::map<int, cyclus::Composition::Ptr> recipes;
+  for (int i = 0; i < n; i++) {
+    int fuel = res_index_map_.Get(mats[i]->obj_id());
+    std::map<int, cyclus::Composition::Ptr>::iterator it = recipes.find(fuel);
+    if (it == recipes.end()) {
+      cyclus::Composition::Ptr recipe =
+          context()->GetRecipe(fuel_outrecipe(mats[i]));
+      it = recipes.insert(std::make_pair(fuel, recipe)).first;
+    }
+    mats[i]->Transmute(it->second);
   }
-  return mapped;
 }
 
 bool Reactor::Discharge() {
   int npop = std::min(n_assem_batch, core.count());
   if (n_assem_spent - spent.count() < npop) {
-    Record("DISCHARGE", "failed");
+    Record(kEventDischargeFailed);
     return false;  // not enough room in spent buffer
   }
 
-  std::stringstream ss;
-  ss << npop << " assemblies";
-  Record("DISCHARGE", ss.str());
-  spent.Push(core.PopN(npop));
+  Record(kEventDischarge, npop);
+  PushSpent(PopCore(npop));
 
-  std::map<std::string, MatVec> spent_mats;
   for (int i = 0; i < fuel_outcommods.size(); i++) {
-    spent_mats = PeekSpent();
-    MatVec mats = spent_mats[fuel_outcommods[i]];
-    double tot_spent = 0;
-    for (int j = 0; j<mats.size(); j++){
-      Material::Ptr m = mats[j];
-      tot_spent += m->quantity();
-    }
+    double tot_spent = SpentQty(fuel_outcommods[i]);
     cyclus::toolkit::RecordTimeSeries<double>("supply"+fuel_outcommods[i], this, tot_spent);
   }
 
@@ -493,6 +588,8 @@ void Reactor::PushInitialInv(){
   LoadInitial(initial_fresh_recipes,initial_fresh_amt, fresh);
   LoadInitial(initial_core_recipes,initial_core_amt, core);
   LoadInitial(initial_spent_recipes,initial_spent_amt, spent);
+  spent_indexed_ = false;  // pick up the initial spent assemblies
+  core_ordered_ = false;  // and the initial core
 }
 
 
@@ -510,14 +607,12 @@ void Reactor::Load() {
     return;
   }
 
-  std::stringstream ss;
-  ss << n << " assemblies";
-  Record("LOAD", ss.str());
-  core.Push(fresh.PopN(n));
+  Record(kEventLoad, n);
+  PushCore(fresh.PopN(n));
 }
 
 std::string Reactor::fuel_incommod(Material::Ptr m) {
-  int i = res_indexes[m->obj_id()];
+  int i = res_index_map_.Get(m->obj_id());
   if (i >= fuel_incommods.size()) {
     throw KeyError("cycamore::Reactor - no incommod for material object");
   }
@@ -525,7 +620,7 @@ std::string Reactor::fuel_incommod(Material::Ptr m) {
 }
 
 std::string Reactor::fuel_outcommod(Material::Ptr m) {
-  int i = res_indexes[m->obj_id()];
+  int i = res_index_map_.Get(m->obj_id());
   if (i >= fuel_outcommods.size()) {
     throw KeyError("cycamore::Reactor - no outcommod for material object");
   }
@@ -533,15 +628,25 @@ std::string Reactor::fuel_outcommod(Material::Ptr m) {
 }
 
 std::string Reactor::fuel_inrecipe(Material::Ptr m) {
-  int i = res_indexes[m->obj_id()];
+  int i = res_index_map_.Get(m->obj_id());
   if (i >= fuel_inrecipes.size()) {
     throw KeyError("cycamore::Reactor - no inrecipe for material object");
   }
   return fuel_inrecipes[i];
 }
 
+cyclus::Composition::Ptr Reactor::fuel_incomp(int i) {
+  if (incomps_.size() != fuel_inrecipes.size()) {
+    incomps_.clear();
+    for (int j = 0; j < fuel_inrecipes.size(); j++) {
+      incomps_.push_back(context()->GetRecipe(fuel_inrecipes[j]));
+    }
+  }
+  return incomps_[i];
+}
+
 std::string Reactor::fuel_outrecipe(Material::Ptr m) {
-  int i = res_indexes[m->obj_id()];
+  int i = res_index_map_.Get(m->obj_id());
   if (i >= fuel_outrecipes.size()) {
     throw KeyError("cycamore::Reactor - no outrecipe for material object");
   }
@@ -549,7 +654,7 @@ std::string Reactor::fuel_outrecipe(Material::Ptr m) {
 }
 
 double Reactor::fuel_pref(Material::Ptr m) {
-  int i = res_indexes[m->obj_id()];
+  int i = res_index_map_.Get(m->obj_id());
   if (i >= fuel_prefs.size()) {
     return 0;
   }
@@ -559,7 +664,7 @@ double Reactor::fuel_pref(Material::Ptr m) {
 void Reactor::index_res(cyclus::Resource::Ptr m, std::string incommod) {
   for (int i = 0; i < fuel_incommods.size(); i++) {
     if (fuel_incommods[i] == incommod) {
-      res_indexes[m->obj_id()] = i;
+      res_index_map_.Set(m->obj_id(), i);
       return;
     }
   }
@@ -567,30 +672,104 @@ void Reactor::index_res(cyclus::Resource::Ptr m, std::string incommod) {
       "cycamore::Reactor - received unsupported incommod material");
 }
 
-std::map<std::string, MatVec> Reactor::PopSpent() {
-  MatVec mats = spent.PopN(spent.count());
-  std::map<std::string, MatVec> mapped;
+void Reactor::PushCore(const MatVec& mats) {
+  core.Push(mats);
+  if (core_ordered_) {
+    core_order_.insert(core_order_.end(), mats.begin(), mats.end());
+  }
+}
+
+MatVec Reactor::PopCore(int n) {
+  MatVec mats = core.PopN(n);
+  if (core_ordered_) {
+    core_order_.erase(core_order_.begin(), core_order_.begin() + n);
+  }
+  return mats;
+}
+
+std::deque<Material::Ptr>& Reactor::CoreOrder() {
+  if (!core_ordered_) {
+    MatVec mats = core.PopN(core.count());
+    core.Push(mats);
+    core_order_.assign(mats.begin(), mats.end());
+    core_ordered_ = true;
+  }
+  return core_order_;
+}
+
+void Reactor::PushSpent(const MatVec& mats) {
+  spent.Push(mats);
+  if (!spent_indexed_) {
+    return;  // picked up when the index is built
+  }
   for (int i = 0; i < mats.size(); i++) {
     std::string commod = fuel_outcommod(mats[i]);
-    mapped[commod].push_back(mats[i]);
+    spent_index_[commod].push_back(mats[i]);
+    spent_qty_[commod] += mats[i]->quantity();
+  }
+}
+
+void Reactor::PopSpent(const std::set<int>& obj_ids) {
+  if (obj_ids.empty()) {
+    return;
   }
 
-  // needed so we trade away oldest assemblies first
-  std::map<std::string, MatVec>::iterator it;
-  for (it = mapped.begin(); it != mapped.end(); ++it) {
-    std::reverse(it->second.begin(), it->second.end());
+  // ResBufs can only pop from the front, so cycle the whole buffer once and
+  // keep everything that wasn't asked for in its original order.
+  std::set<std::string> commods;
+  MatVec mats = spent.PopN(spent.count());
+  for (int i = 0; i < mats.size(); i++) {
+    if (obj_ids.count(mats[i]->obj_id()) == 0) {
+      spent.Push(mats[i]);
+    } else if (spent_indexed_) {
+      commods.insert(fuel_outcommod(mats[i]));
+    }
+  }
+
+  // only the index entries of outcommods that lost assemblies need a pass
+  std::set<std::string>::iterator c;
+  for (c = commods.begin(); c != commods.end(); ++c) {
+    std::deque<Material::Ptr>& idx = spent_index_[*c];
+    std::deque<Material::Ptr> keep;
+    double kept = 0;
+    for (int i = 0; i < idx.size(); i++) {
+      if (obj_ids.count(idx[i]->obj_id()) == 0) {
+        keep.push_back(idx[i]);
+        kept += idx[i]->quantity();
+      }
+    }
+    // resum what is left rather than subtracting so round-off from many
+    // pushes and pops can't accumulate in the running total.
+    spent_qty_[*c] = kept;
+    idx.swap(keep);
   }
 
-  return mapped;
+  std::set<int>::const_iterator id;
+  for (id = obj_ids.begin(); id != obj_ids.end(); ++id) {
+    res_index_map_.Erase(*id);
+  }
 }
 
-void Reactor::PushSpent(std::map<std::string, MatVec> leftover) {
-  std::map<std::string, MatVec>::iterator it;
-  for (it = leftover.begin(); it != leftover.end(); ++it) {
-    // undo reverse in PopSpent to make sure oldest assemblies come out first
-    std::reverse(it->second.begin(), it->second.end());
-    spent.Push(it->second);
+std::map<std::string, std::deque<Material::Ptr> >& Reactor::SpentIndex() {
+  if (!spent_indexed_) {
+    spent_index_.clear();
+    spent_qty_.clear();
+    MatVec mats = spent.PopN(spent.count());
+    spent.Push(mats);
+    for (int i = 0; i < mats.size(); i++) {
+      std::string commod = fuel_outcommod(mats[i]);
+      spent_index_[commod].push_back(mats[i]);
+      spent_qty_[commod] += mats[i]->quantity();
+    }
+    spent_indexed_ = true;
   }
+  return spent_index_;
+}
+
+double Reactor::SpentQty(std::string outcommod) {
+  SpentIndex();  // make sure the totals are current
+  std::map<std::string, double>::iterator it = spent_qty_.find(outcommod);
+  return it == spent_qty_.end() ? 0 : it->second;
 }
 
 void Reactor::RecordSideProduct(bool produce){
@@ -615,6 +794,107 @@ void Reactor::RecordSideProduct(bool produce){
   }
 }
 
+void Reactor::NotifyTimeSeries(std::string tsname, double value) {
+  typedef std::function<void(cyclus::Agent*, int, double, std::string)> fn_t;
+  std::vector<cyclus::toolkit::time_series_listener_t>& fns =
+      cyclus::toolkit::TIME_SERIES_LISTENERS[tsname];
+  for (int i = 0; i < fns.size(); i++) {
+    boost::get<fn_t>(fns[i])(this, context()->time(), value, tsname);
+  }
+}
+
+void Reactor::RecordInterval(bool produce) {
+  int t = context()->time();
+  if (interval_start >= 0 && produce != interval_producing) {
+    FlushInterval();
+  }
+  if (interval_start < 0) {
+    interval_start = t;
+    interval_producing = produce;
+  }
+  interval_end = t + 1;
+
+  if (t == context()->sim_info().duration - 1) {
+    FlushInterval();  // last time step - nothing else will close it
+  }
+}
+
+void Reactor::FlushInterval() {
+  if (interval_start < 0) {
+    return;
+  }
+
+  context()
+      ->NewDatum("ReactorPowerIntervals")
+      ->AddVal("AgentId", id())
+      ->AddVal("StartTime", interval_start)
+      ->AddVal("EndTime", interval_end)
+      ->AddVal("Value", interval_producing ? power_cap : 0.0)
+      ->Record();
+
+  if (hybrid_) {
+    for (int i = 0; i < side_products.size(); i++) {
+      context()
+          ->NewDatum("ReactorSideProductIntervals")
+          ->AddVal("AgentId", id())
+          ->AddVal("Product", side_products[i])
+          ->AddVal("StartTime", interval_start)
+          ->AddVal("EndTime", interval_end)
+          ->AddVal("Value", interval_producing ? side_product_quantity[i] : 0)
+          ->Record();
+    }
+  }
+
+  interval_start = -1;
+}
+
+void Reactor::Record(ReactorEvent event, int count) {
+  context()
+      ->NewDatum("ReactorEventCounts")
+      ->AddVal("AgentId", id())
+      ->AddVal("Time", context()->time())
+      ->AddVal("Event", static_cast<int>(event))
+      ->AddVal("Count", count)
+      ->Record();
+
+  if (!legacy_event_output) {
+    return;
+  }
+
+  std::string name;
+  std::string val;
+  switch (event) {
+    case kEventRetired:
+      name = "RETIRED";
+      break;
+    case kEventCycleStart:
+      name = "CYCLE_START";
+      break;
+    case kEventCycleEnd:
+      name = "CYCLE_END";
+      break;
+    case kEventLoad:
+      name = "LOAD";
+      break;
+    case kEventTransmute:
+      name = "TRANSMUTE";
+      break;
+    case kEventDischarge:
+      name = "DISCHARGE";
+      break;
+    case kEventDischargeFailed:
+      name = "DISCHARGE";
+      val = "failed";
+      break;
+  }
+  if (event == kEventLoad || event == kEventTransmute || event == kEventDischarge) {
+    std::stringstream ss;
+    ss << count << " assemblies";
+    val = ss.str();
+  }
+  Record(name, val);
+}
+
 void Reactor::Record(std::string name, std::string val) {
   context()
       ->NewDatum("ReactorEvents")
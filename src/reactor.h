@@ -1,11 +1,168 @@
 #ifndef CYCAMORE_SRC_REACTOR_H_
 #define CYCAMORE_SRC_REACTOR_H_
 
+#include <deque>
+
 #include "cyclus.h"
 #include "cycamore_version.h"
 
 namespace cycamore {
 
+/// Event codes for the Event column of the ReactorEventCounts table.  Values
+/// are part of the output format - only ever add new codes at the end.
+enum ReactorEvent {
+  kEventRetired = 0,
+  kEventCycleStart = 1,
+  kEventCycleEnd = 2,
+  // Count is the number of assemblies for the next three events
+  kEventLoad = 3,
+  kEventTransmute = 4,
+  kEventDischarge = 5,
+  // the spent fuel inventory was too full to discharge a batch
+  kEventDischargeFailed = 6,
+};
+
+/// ResIndexMap is a compact open-addressing hash map from resource object ids
+/// to fuel indexes.  Keys and values live in flat arrays probed linearly, so
+/// lookups touch one or two cache lines instead of walking a tree, and the
+/// table shrinks back down as entries are erased.  Looking up a missing key
+/// returns zero (like std::map::operator[]) without inserting it.
+class ResIndexMap {
+ public:
+  ResIndexMap() : n_(0), n_used_(0) {}
+
+  /// Returns the index stored for obj_id or zero if there is none.
+  int Get(int obj_id) const {
+    if (keys_.empty()) {
+      return 0;
+    }
+    for (int i = Slot(obj_id);; i = (i + 1) & (keys_.size() - 1)) {
+      if (keys_[i] == obj_id) {
+        return vals_[i];
+      } else if (keys_[i] == kEmpty) {
+        return 0;
+      }
+    }
+  }
+
+  /// Stores index for obj_id, replacing any existing index.
+  void Set(int obj_id, int index) {
+    if (2 * (n_used_ + 1) > keys_.size()) {
+      Rehash(n_ + 1);
+    }
+    int tomb = -1;
+    int i = Slot(obj_id);
+    for (;; i = (i + 1) & (keys_.size() - 1)) {
+      if (keys_[i] == obj_id) {
+        vals_[i] = index;
+        return;
+      } else if (keys_[i] == kTomb && tomb < 0) {
+        tomb = i;
+      } else if (keys_[i] == kEmpty) {
+        break;
+      }
+    }
+    if (tomb >= 0) {
+      i = tomb;  // reuse the first tombstone on the probe path
+    } else {
+      n_used_++;
+    }
+    keys_[i] = obj_id;
+    vals_[i] = index;
+    n_++;
+  }
+
+  /// Removes obj_id (if present).
+  void Erase(int obj_id) {
+    if (keys_.empty()) {
+      return;
+    }
+    for (int i = Slot(obj_id);; i = (i + 1) & (keys_.size() - 1)) {
+      if (keys_[i] == obj_id) {
+        keys_[i] = kTomb;
+        n_--;
+        break;
+      } else if (keys_[i] == kEmpty) {
+        return;
+      }
+    }
+    if (n_ == 0) {
+      Clear();
+    } else if (8 * n_ < keys_.size() && keys_.size() > kMinSize) {
+      Rehash(n_);
+    }
+  }
+
+  void Clear() {
+    keys_.clear();
+    vals_.clear();
+    n_ = 0;
+    n_used_ = 0;
+  }
+
+  /// Returns the number of stored entries.
+  int size() const { return n_; }
+
+  /// Returns the number of slots in the table.
+  int capacity() const { return keys_.size(); }
+
+  /// Copies all entries into m (e.g. for snapshotting).
+  void ToMap(std::map<int, int>* m) const {
+    m->clear();
+    for (int i = 0; i < keys_.size(); i++) {
+      if (keys_[i] >= 0) {
+        (*m)[keys_[i]] = vals_[i];
+      }
+    }
+  }
+
+  /// Replaces all entries with those in m.
+  void FromMap(const std::map<int, int>& m) {
+    Clear();
+    std::map<int, int>::const_iterator it;
+    for (it = m.begin(); it != m.end(); ++it) {
+      Set(it->first, it->second);
+    }
+  }
+
+ private:
+  // object ids are never negative, so negative keys mark unused slots
+  enum { kEmpty = -1, kTomb = -2, kMinSize = 16 };
+
+  int Slot(int obj_id) const {
+    // obj ids are handed out sequentially - scramble them so neighbors don't
+    // pile up in the same run of slots.
+    unsigned int h = static_cast<unsigned int>(obj_id) * 2654435761u;
+    return (h ^ (h >> 16)) & (keys_.size() - 1);
+  }
+
+  // Rebuilds the table with room for at least n entries, dropping tombstones.
+  void Rehash(int n) {
+    int size = kMinSize;
+    while (size < 4 * n) {
+      size *= 2;
+    }
+    std::vector<int> keys;
+    std::vector<int> vals;
+    keys.swap(keys_);
+    vals.swap(vals_);
+    keys_.assign(size, kEmpty);
+    vals_.assign(size, 0);
+    n_ = 0;
+    n_used_ = 0;
+    for (int i = 0; i < keys.size(); i++) {
+      if (keys[i] >= 0) {
+        Set(keys[i], vals[i]);
+      }
+    }
+  }
+
+  std::vector<int> keys_;
+  std::vector<int> vals_;
+  int n_;       // live entries
+  int n_used_;  // live entries plus tombstones
+};
+
 /// Reactor is a simple, general reactor based on static compositional
 /// transformations to model fuel burnup.  The user specifies a set of input
 /// fuels and corresponding burnt compositions that fuel is transformed to when
@@ -51,6 +208,11 @@ namespace cycamore {
 /// mid-cycle) when the reactor is decommissioned, half (rounded up to nearest
 /// int) of its assemblies are transmuted to their respective burnt
 /// compositions.
+///
+/// With interval_output enabled, power and side product output is written as
+/// runs of equal values instead of one row per time step.  Per time step
+/// views for existing analysis scripts can be added to an SQLite output file
+/// with scripts/expand_intervals.py.
 
 class Reactor : public cyclus::Facility,
   public cyclus::toolkit::CommodityProducer {
@@ -105,6 +267,8 @@ class Reactor : public cyclus::Facility,
   "", \
 }
 
+  friend class ReactorTest;
+
  public:
   Reactor(cyclus::Context* ctx);
   virtual ~Reactor(){};
@@ -115,6 +279,7 @@ class Reactor : public cyclus::Facility,
   virtual void Tock();
   virtual void EnterNotify();
   virtual bool CheckDecommissionCondition();
+  virtual void Decommission();
   virtual void Build(cyclus::Agent* parent);
 
   virtual void AcceptMatlTrades(const std::vector<std::pair<
@@ -143,6 +308,9 @@ class Reactor : public cyclus::Facility,
   std::string fuel_outrecipe(cyclus::Material::Ptr m);
   double fuel_pref(cyclus::Material::Ptr m);
 
+  /// Returns the composition of the i'th fuel's inrecipe.
+  cyclus::Composition::Ptr fuel_incomp(int i);
+
   bool retired() {
     return exit_time() != -1 && context()->time() > exit_time();
   }
@@ -150,6 +318,19 @@ class Reactor : public cyclus::Facility,
   /// Store fuel info index for the given resource received on incommod.
   void index_res(cyclus::Resource::Ptr m, std::string incommod);
 
+  /// Pref or recipe changes sorted by time along with a cursor to the next
+  /// change that hasn't happened yet.
+  struct ChangeQueue {
+    ChangeQueue() : next(0) {}
+    std::vector<int> order;  // change indexes sorted by time
+    int next;
+  };
+
+  /// Returns the index of the next change in times scheduled for time t or -1
+  /// if there are no more for t.  Each change is returned only once.  The
+  /// queue is built on first use.
+  int NextChange(const std::vector<int>& times, ChangeQueue* q, int t);
+
   /// Discharge a batch from the core if there is room in the spent fuel
   /// inventory.  Returns true if a batch was successfully discharged.
   bool Discharge();
@@ -164,24 +345,54 @@ class Reactor : public cyclus::Facility,
   /// Records production of side products from the reactor
   void RecordSideProduct(bool produce);
 
+  /// Passes value to the listeners registered for the tsname time series, the
+  /// same as RecordTimeSeries but without writing a TimeSeries row.
+  void NotifyTimeSeries(std::string tsname, double value);
+
+  /// Extends the open power/side product interval with the current time step
+  /// - flushing it first if the reactor switched between producing and not.
+  void RecordInterval(bool produce);
+
+  /// Writes the open power/side product interval (if any) to the output db.
+  void FlushInterval();
+
   /// Transmute the specified number of assemblies in the core to their
   /// fully burnt state as defined by their outrecipe.
   void Transmute(int n_assem);
 
+  /// Records a reactor event with the number of assemblies involved (if
+  /// any) to the ReactorEventCounts table and, if legacy_event_output is on,
+  /// to the string based ReactorEvents table.
+  void Record(ReactorEvent event, int count = 0);
+
   /// Records a reactor event to the output db with the given name and note val.
   void Record(std::string name, std::string val);
 
-  /// Complement of PopSpent - must be called with all materials passed that
-  /// were not traded away to other agents.
-  void PushSpent(std::map<std::string, cyclus::toolkit::MatVec> leftover);
+  /// Pushes mats onto the back of the core and appends them to the core order
+  /// mirror.
+  void PushCore(const cyclus::toolkit::MatVec& mats);
 
-  /// Returns all spent assemblies indexed by outcommod - removing them from
-  /// the spent fuel buffer.
-  std::map<std::string, cyclus::toolkit::MatVec> PopSpent();
+  /// Pops the n oldest assemblies from the core (and its order mirror).
+  cyclus::toolkit::MatVec PopCore(int n);
 
-  /// Returns all spent assemblies indexed by outcommod without removing them
-  /// from the spent fuel buffer.
-  std::map<std::string, cyclus::toolkit::MatVec> PeekSpent();
+  /// Returns the core assemblies from oldest to newest without cycling the
+  /// core buffer, building the mirror from the buffer if needed.
+  std::deque<cyclus::Material::Ptr>& CoreOrder();
+
+  /// Pushes mats onto the back of the spent fuel buffer and appends them to
+  /// the spent fuel index.
+  void PushSpent(const cyclus::toolkit::MatVec& mats);
+
+  /// Removes the given materials from the spent fuel buffer (and index)
+  /// while preserving the order of the rest.
+  void PopSpent(const std::set<int>& obj_ids);
+
+  /// Returns the spent fuel index - all spent assemblies grouped by outcommod
+  /// from oldest to newest - building it from the spent buffer if needed.
+  std::map<std::string, std::deque<cyclus::Material::Ptr> >& SpentIndex();
+
+  /// Returns the total quantity of spent fuel held for outcommod.
+  double SpentQty(std::string outcommod);
 
   //loads any spent or fresh fuel assemblies into resource buffer
   void LoadInitial(std::vector<std::string>& initial_recipes,
@@ -495,6 +706,90 @@ class Reactor : public cyclus::Facility,
     "uitype": "bool"}
   bool keep_packaging;
 
+  #pragma cyclus var { \
+    "default": False, \
+    "tooltip": "Whether to request all needed fuel assemblies at once", \
+    "doc": "If true, fuel is requested with a single all-or-nothing request " \
+           "per fuel commodity for all the assemblies needed on a time " \
+           "step instead of separate requests for each assembly.  This " \
+           "shrinks the exchange by roughly the number of assemblies " \
+           "ordered, but a supplier must be able to provide the whole " \
+           "order of a single fuel for it to be filled.  If a batch " \
+           "request goes unmatched, fuel is requested per assembly until " \
+           "the order is filled, so throughput limited suppliers still " \
+           "refuel the reactor.  Received fuel is split back into " \
+           "individual assemblies.", \
+    "uilabel": "Batch Fuel Requests", \
+    "uitype": "bool"}
+  bool batch_requests;
+
+  // batch_sent is set while a batch request waits to be filled, and
+  // batch_fallback once one went unmatched (fuel is then requested per
+  // assembly until the order is filled) - persisted so restarts keep the mode.
+  #pragma cyclus var {"default": False, "doc": "This should NEVER be set manually", \
+                      "internal": True \
+  }
+  bool batch_sent;
+  #pragma cyclus var {"default": False, "doc": "This should NEVER be set manually", \
+                      "internal": True \
+  }
+  bool batch_fallback;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "tooltip": "Whether to record power and side products as intervals", \
+    "doc": "If true, power and side product output is written as one row " \
+           "per run of time steps with the same value to the " \
+           "ReactorPowerIntervals and ReactorSideProductIntervals tables " \
+           "(StartTime inclusive, EndTime exclusive) instead of one row " \
+           "per time step to the TimeSeriesPower, TimeSeriessupplyPOWER " \
+           "and ReactorSideProducts tables.  Time series listeners are " \
+           "still notified every time step.", \
+    "uilabel": "Interval Power Output", \
+    "uitype": "bool"}
+  bool interval_output;
+
+  // Interval currently being accumulated for interval_output - these must be
+  // persisted so a restarted simulation can continue the open interval.
+  #pragma cyclus var {"default": -1, "doc": "This should NEVER be set manually", \
+                      "internal": True \
+  }
+  int interval_start;
+  #pragma cyclus var {"default": -1, "doc": "This should NEVER be set manually", \
+                      "internal": True \
+  }
+  int interval_end;
+  #pragma cyclus var {"default": False, "doc": "This should NEVER be set manually", \
+                      "internal": True \
+  }
+  bool interval_producing;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "tooltip": "Whether to also write the string based ReactorEvents table", \
+    "doc": "Reactor events are always recorded to the ReactorEventCounts " \
+           "table with an integer event code and assembly count.  If true, " \
+           "they are also recorded to the older ReactorEvents table with " \
+           "the event name and a text value (e.g. '3 assemblies') for " \
+           "analysis scripts that still read it.", \
+    "uilabel": "Legacy Event Output", \
+    "uitype": "bool"}
+  bool legacy_event_output;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "tooltip": "Whether to bid each spent assembly at most once", \
+    "doc": "If true, each request for spent fuel is bid its own slice " \
+           "of the spent fuel inventory (oldest assemblies first) just " \
+           "large enough to cover it, instead of every request being bid " \
+           "the oldest assemblies that cover it.  This keeps the number " \
+           "of bids at or below the number of spent assemblies.  When " \
+           "there is less spent fuel than requested, every request is " \
+           "bid the oldest assemblies that cover it as usual.", \
+    "uilabel": "Sliced Spent Fuel Bids", \
+    "uitype": "bool"}
+  bool sliced_bids;
+
   // Resource inventories - these must be defined AFTER/BELOW the member vars
   // referenced (e.g. n_batch_fresh, assem_size, etc.).
   #pragma cyclus var {"capacity": "n_assem_fresh * assem_size"}
@@ -514,13 +809,45 @@ class Reactor : public cyclus::Facility,
 
   // This variable should be hidden/unavailable in ui.  Maps resource object
   // id's to the index for the incommod through which they were received.
+  // Lookups during the simulation go through res_index_map_ - this is only
+  // filled in while snapshotting and read back on restart.
   #pragma cyclus var {"default": {}, "doc": "This should NEVER be set manually", \
                       "internal": True \
   }
   std::map<int, int> res_indexes;
 
+  // live copy of res_indexes
+  ResIndexMap res_index_map_;
+
   // populated lazily and no need to persist.
   std::set<std::string> uniq_outcommods_;
+
+  // Resolved fuel_inrecipes compositions.  Populated lazily, reset whenever a
+  // recipe change fires, and no need to persist.
+  std::vector<cyclus::Composition::Ptr> incomps_;
+
+  // Time-ordered views of the pref/recipe change schedules so Tick doesn't
+  // have to scan them every time step.  Built lazily - no need to persist.
+  ChangeQueue pref_change_queue_;
+  ChangeQueue recipe_change_queue_;
+
+  // Mirrors the spent buffer grouped by outcommod (oldest first) so bids and
+  // supply reporting don't need to cycle every assembly through the buffer.
+  // Built lazily from the buffer (e.g. after a restart) and then kept up to
+  // date by PushSpent and PopSpent - no need to persist.
+  std::map<std::string, std::deque<cyclus::Material::Ptr> > spent_index_;
+  bool spent_indexed_;
+
+  // Mirrors the core buffer from oldest to newest so Transmute can read the
+  // assemblies about to be discharged without cycling the buffer.  Built
+  // lazily like spent_index_ and kept up to date by PushCore and PopCore.
+  std::deque<cyclus::Material::Ptr> core_order_;
+  bool core_ordered_;
+
+  // Running total quantity of the spent fuel in each spent_index_ entry, used
+  // to record the per-commodity supply time series.  Added to on push and
+  // resummed from the remaining entries on pop.
+  std::map<std::string, double> spent_qty_;
 };
 
 } // namespace cycamore
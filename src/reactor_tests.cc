@@ -3,6 +3,8 @@
 #include <sstream>
 
 #include "cyclus.h"
+#include "reactor.h"
+#include "test_context.h"
 
 using pyne::nucname::id;
 using cyclus::Composition;
@@ -137,6 +139,148 @@ TEST(ReactorTests, BatchSizes) {
   EXPECT_EQ(7+3*(simdur-1), qr.rows.size());
 }
 
+// in batched request mode the whole order comes in one transaction per time
+// step and is split back into assemblies, so the reactor must run exactly as
+// it does with per-assembly requests.
+TEST(ReactorTests, BatchRequests) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste</val>    </fuel_outcommods>  "
+     ""
+     "  <cycle_time>1</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>7</n_assem_core>  "
+     "  <n_assem_batch>3</n_assem_batch>  "
+     "  <power_cap>100</power_cap>  "
+     "  <batch_requests>1</batch_requests>  ";
+
+  int simdur = 50;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  int id = sim.Run();
+
+  QueryResult qr = sim.db().Query("Transactions", NULL);
+  EXPECT_EQ(simdur, qr.rows.size());
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Event", "==", static_cast<int>(kEventLoad)));
+  qr = sim.db().Query("ReactorEventCounts", &conds);
+  ASSERT_EQ(simdur, qr.rows.size());
+  EXPECT_EQ(7, qr.GetVal<int>("Count", 0));
+  EXPECT_EQ(3, qr.GetVal<int>("Count", 1));
+
+  conds[0] = Cond("Value", "==", 0.0);
+  qr = sim.db().Query("TimeSeriesPower", &conds);
+  EXPECT_EQ(0, qr.rows.size()) << "reactor should never have shut down";
+}
+
+// a batch request no supplier can fill as a whole must not starve the
+// reactor - it falls back to per-assembly requests and still refuels from a
+// throughput limited source.
+TEST(ReactorTests, BatchRequestsFallback) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste</val>    </fuel_outcommods>  "
+     ""
+     "  <cycle_time>1</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>7</n_assem_core>  "
+     "  <n_assem_batch>3</n_assem_batch>  "
+     "  <power_cap>100</power_cap>  "
+     "  <batch_requests>1</batch_requests>  ";
+
+  int simdur = 10;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").capacity(2).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  int id = sim.Run();
+
+  // the first batch of 7 goes unmatched, then 2 assemblies arrive per time
+  // step until the core is full at t=4
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Time", "==", 0));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(0, qr.rows.size());
+  for (int t = 1; t < 5; t++) {
+    conds[0] = Cond("Time", "==", t);
+    qr = sim.db().Query("Transactions", &conds);
+    EXPECT_EQ(t < 4 ? 2 : 1, qr.rows.size()) << "t=" << t;
+  }
+
+  conds[0] = Cond("Value", ">", 0.0);
+  qr = sim.db().Query("TimeSeriesPower", &conds);
+  EXPECT_LT(0, qr.rows.size()) << "reactor never started";
+}
+
+// typed event records must carry the same information as the legacy string
+// event records.
+TEST(ReactorTests, EventCounts) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste</val>    </fuel_outcommods>  "
+     ""
+     "  <cycle_time>1</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>7</n_assem_core>  "
+     "  <n_assem_batch>3</n_assem_batch>  "
+     "  <n_assem_spent>6</n_assem_spent>  "
+     "  <legacy_event_output>1</legacy_event_output>  ";
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  int id = sim.Run();
+
+  QueryResult legacy = sim.db().Query("ReactorEvents", NULL);
+  QueryResult typed = sim.db().Query("ReactorEventCounts", NULL);
+  ASSERT_EQ(legacy.rows.size(), typed.rows.size());
+
+  const char* names[] = {"RETIRED", "CYCLE_START", "CYCLE_END", "LOAD",
+                         "TRANSMUTE", "DISCHARGE", "DISCHARGE"};
+  int ndischarge = 0;
+  int nfailed = 0;
+  for (int i = 0; i < typed.rows.size(); i++) {
+    int event = typed.GetVal<int>("Event", i);
+    int count = typed.GetVal<int>("Count", i);
+    ASSERT_LE(0, event);
+    ASSERT_GT(7, event);
+    EXPECT_EQ(legacy.GetVal<int>("Time", i), typed.GetVal<int>("Time", i));
+    EXPECT_EQ(names[event], legacy.GetVal<std::string>("Event", i));
+
+    std::string val = legacy.GetVal<std::string>("Value", i);
+    if (event == kEventLoad || event == kEventTransmute ||
+        event == kEventDischarge) {
+      std::stringstream ss;
+      ss << count << " assemblies";
+      EXPECT_EQ(ss.str(), val);
+    } else if (event == kEventDischargeFailed) {
+      EXPECT_EQ("failed", val);
+    } else {
+      EXPECT_EQ("", val);
+    }
+    ndischarge += event == kEventDischarge;
+    nfailed += event == kEventDischargeFailed;
+  }
+
+  // the spent fuel inventory fills up after two discharges
+  EXPECT_EQ(2, ndischarge);
+  EXPECT_LT(0, nfailed);
+}
+
 // tests that the refueling period between cycle end and start of the next
 // cycle is honored.
 TEST(ReactorTests, RefuelTimes) {
@@ -577,6 +721,289 @@ TEST(ReactorTests, SpentFuelProperCommodTracking) {
   EXPECT_EQ(2*(simdur-1), qr.rows.size());
 }
 
+// each assembly in a mixed core must be transmuted to its own fuel's
+// outrecipe.
+TEST(ReactorTests, MixedCoreTransmute) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      <val>mox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> <val>spentmox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      <val>mox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste1</val>   <val>waste2</val>   </fuel_outcommods>  "
+     ""
+     "  <cycle_time>1</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>6</n_assem_core>  "
+     "  <n_assem_batch>3</n_assem_batch>  ";
+
+  int simdur = 6;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").capacity(1).Finalize();
+  sim.AddSource("mox").capacity(2).Finalize();
+  sim.AddSink("waste1").Finalize();
+  sim.AddSink("waste2").Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("mox", c_mox());
+  Composition::Ptr spentuox = c_spentuox();
+  Composition::Ptr spentmox = c_spentmox();
+  sim.AddRecipe("spentuox", spentuox);
+  sim.AddRecipe("spentmox", spentmox);
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  conds.push_back(Cond("Commodity", "==", std::string("waste1")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_LT(0, qr.rows.size());
+  for (int i = 0; i < qr.rows.size(); i++) {
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+    EXPECT_EQ(spentuox->id(), m->comp()->id());
+  }
+
+  conds[1] = Cond("Commodity", "==", std::string("waste2"));
+  qr = sim.db().Query("Transactions", &conds);
+  EXPECT_LT(0, qr.rows.size());
+  for (int i = 0; i < qr.rows.size(); i++) {
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+    EXPECT_EQ(spentmox->id(), m->comp()->id());
+  }
+}
+
+// The supply<commod> time series must track the spent fuel held for each
+// outcommod as assemblies are discharged and traded away.
+TEST(ReactorTests, SpentFuelSupplyRecords) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      <val>mox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> <val>spentmox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      <val>mox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste1</val>   <val>waste2</val>   </fuel_outcommods>  "
+     ""
+     "  <cycle_time>1</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>3</n_assem_core>  "
+     "  <n_assem_batch>3</n_assem_batch>  "
+     "  <n_assem_spent>1000</n_assem_spent>  ";
+
+  int simdur = 20;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").capacity(1).Finalize();
+  sim.AddSource("mox").capacity(2).Finalize();
+  sim.AddSink("waste2").capacity(1).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  sim.AddRecipe("mox", c_mox());
+  sim.AddRecipe("spentmox", c_spentmox());
+  int id = sim.Run();
+
+  // a batch of 1 uox and 2 mox assemblies is discharged every time step
+  // starting at t=1 and one waste2 assembly is traded away every time step
+  // after that.
+  std::vector<Cond> conds;
+  conds.push_back(Cond("AgentId", "==", id));
+  conds.push_back(Cond("Time", "==", 0));
+  for (int t = 1; t < simdur; t++) {
+    conds[1] = Cond("Time", "==", t);
+    QueryResult qr = sim.db().Query("TimeSeriessupplywaste1", &conds);
+    ASSERT_EQ(1, qr.rows.size()) << "t=" << t;
+    EXPECT_DOUBLE_EQ(t, qr.GetVal<double>("Value")) << "t=" << t;
+
+    qr = sim.db().Query("TimeSeriessupplywaste2", &conds);
+    ASSERT_EQ(1, qr.rows.size()) << "t=" << t;
+    EXPECT_DOUBLE_EQ(t + 1, qr.GetVal<double>("Value")) << "t=" << t;
+  }
+}
+
+// Spent assemblies must be traded away oldest first - here the initial spent
+// inventory must go out before any assemblies discharged during the sim.
+TEST(ReactorTests, SpentFuelOldestFirst) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      <val>mox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> <val>spentmox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      <val>mox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste</val>    <val>waste</val>    </fuel_outcommods>  "
+     ""
+     "  <cycle_time>1</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>1</n_assem_core>  "
+     "  <n_assem_batch>1</n_assem_batch>  "
+     "  <n_assem_spent>10</n_assem_spent>  "
+     ""
+     "  <initial_spent_recipes> <val>spentmox</val> </initial_spent_recipes> "
+     "  <initial_spent_amt> <val>3</val> </initial_spent_amt> ";
+
+  int simdur = 6;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").Finalize();
+  sim.AddSink("waste").capacity(1).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  sim.AddRecipe("mox", c_mox());
+  sim.AddRecipe("spentmox", c_spentmox());
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  conds.push_back(Cond("Time", "==", 0));
+  for (int t = 0; t < simdur; t++) {
+    conds[1] = Cond("Time", "==", t);
+    QueryResult qr = sim.db().Query("Transactions", &conds);
+    ASSERT_EQ(1, qr.rows.size()) << "t=" << t;
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId"));
+    MatQuery mq(m);
+    // u235 mass fractions of spentmox and spentuox
+    double want = t < 3 ? .2 / 101.1 : .8 / 101.8;
+    EXPECT_NEAR(want, mq.mass_frac(pyne::nucname::id("u235")), 1e-8)
+        << "t=" << t;
+  }
+}
+
+TEST(ReactorTests, ResIndexMap) {
+  ResIndexMap idx;
+  std::map<int, int> want;
+  EXPECT_EQ(0, idx.Get(7));
+  EXPECT_EQ(0, idx.size());
+
+  // interleave inserts, overwrites and erases of sequential object ids like a
+  // reactor cycling assemblies through its buffers
+  for (int i = 0; i < 5000; i++) {
+    idx.Set(i, i % 3);
+    want[i] = i % 3;
+    if (i % 7 == 0) {
+      idx.Set(i / 2, 5);
+      want[i / 2] = 5;
+    }
+    if (i >= 100) {
+      idx.Erase(i - 100);
+      want.erase(i - 100);
+    }
+  }
+  ASSERT_EQ(want.size(), idx.size());
+  for (int i = 0; i < 6000; i++) {
+    int w = want.count(i) > 0 ? want[i] : 0;
+    EXPECT_EQ(w, idx.Get(i)) << "obj_id=" << i;
+  }
+  EXPECT_EQ(0, idx.Get(6000));
+  EXPECT_EQ(want.size(), idx.size()) << "lookups must not insert";
+  EXPECT_GE(8 * idx.size(), idx.capacity())
+      << "table must stay proportional to the live entries";
+
+  std::map<int, int> snap;
+  idx.ToMap(&snap);
+  EXPECT_EQ(want, snap);
+  ResIndexMap restored;
+  restored.FromMap(snap);
+  std::map<int, int>::iterator it;
+  for (it = want.begin(); it != want.end(); ++it) {
+    EXPECT_EQ(it->second, restored.Get(it->first));
+  }
+
+  for (it = want.begin(); it != want.end(); ++it) {
+    idx.Erase(it->first);
+  }
+  EXPECT_EQ(0, idx.size());
+  EXPECT_EQ(0, idx.capacity());
+}
+
+// with sliced bids, several requesters must still all be served when there is
+// enough spent fuel to go around.
+TEST(ReactorTests, SlicedBids) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste</val>    </fuel_outcommods>  "
+     ""
+     "  <cycle_time>10</cycle_time>  "
+     "  <refuel_time>0</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>1</n_assem_core>  "
+     "  <n_assem_batch>1</n_assem_batch>  "
+     "  <n_assem_spent>10</n_assem_spent>  "
+     "  <sliced_bids>1</sliced_bids>  "
+     ""
+     "  <initial_spent_recipes> <val>spentuox</val> </initial_spent_recipes> "
+     "  <initial_spent_amt> <val>10</val> </initial_spent_amt> ";
+
+  int simdur = 2;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").Finalize();
+  sim.AddSink("waste").capacity(2).Finalize();
+  sim.AddSink("waste").capacity(2).Finalize();
+  sim.AddSink("waste").capacity(2).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  conds.push_back(Cond("Time", "==", 0));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(6, qr.rows.size());
+
+  // only 4 assemblies left for 3 sinks
+  conds[1] = Cond("Time", "==", 1);
+  qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(4, qr.rows.size());
+}
+
+// Returns the number of spent assemblies each sink received from a reactor
+// holding 4 spent assemblies that is asked for 3 apiece by two sinks.
+std::map<int, int> ScarceSpentTrades(bool sliced) {
+  std::stringstream config;
+  config
+     << "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
+     << "  <fuel_outrecipes> <val>spentuox</val> </fuel_outrecipes>  "
+     << "  <fuel_incommods>  <val>uox</val>      </fuel_incommods>  "
+     << "  <fuel_outcommods> <val>waste</val>    </fuel_outcommods>  "
+     << ""
+     << "  <cycle_time>10</cycle_time>  "
+     << "  <refuel_time>0</refuel_time>  "
+     << "  <assem_size>1</assem_size>  "
+     << "  <n_assem_core>1</n_assem_core>  "
+     << "  <n_assem_batch>1</n_assem_batch>  "
+     << "  <n_assem_spent>4</n_assem_spent>  "
+     << "  <sliced_bids>" << sliced << "</sliced_bids>  "
+     << ""
+     << "  <initial_spent_recipes> <val>spentuox</val> </initial_spent_recipes> "
+     << "  <initial_spent_amt> <val>4</val> </initial_spent_amt> ";
+
+  int simdur = 1;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config.str(),
+                      simdur);
+  sim.AddSource("uox").Finalize();
+  sim.AddSink("waste").capacity(3).Finalize();
+  sim.AddSink("waste").capacity(3).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  std::map<int, int> received;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    received[qr.GetVal<int>("ReceiverId", i)]++;
+  }
+  return received;
+}
+
+// with sliced bids, requesters competing for less spent fuel than they ask
+// for must be served exactly as without sliced bids.
+TEST(ReactorTests, SlicedBidsScarce) {
+  std::map<int, int> sliced = ScarceSpentTrades(true);
+  std::map<int, int> unsliced = ScarceSpentTrades(false);
+
+  int n = 0;
+  std::map<int, int>::iterator it;
+  for (it = sliced.begin(); it != sliced.end(); ++it) {
+    n += it->second;
+  }
+  EXPECT_EQ(4, n);
+  EXPECT_EQ(unsliced, sliced);
+}
+
 // The user can optionally omit fuel preferences.  In the case where
 // preferences are adjusted, the ommitted preference vector must be populated
 // with default values - if it wasn't then preferences won't be adjusted
@@ -831,6 +1258,91 @@ TEST(ReactorTests, ByProduct) {
   EXPECT_EQ(5, qr.rows.size());
 }
 
+// interval output expanded back to per time step values must match the
+// regular per time step power and side product output.
+TEST(ReactorTests, IntervalOutput) {
+  std::string config =
+     "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
+     "  <fuel_outrecipes> <val>spentuox</val> </fuel_outrecipes>  "
+     "  <fuel_incommods>  <val>uox</val>      </fuel_incommods>  "
+     "  <fuel_outcommods> <val>waste</val>    </fuel_outcommods>  "
+     ""
+     "  <cycle_time>3</cycle_time>  "
+     "  <refuel_time>2</refuel_time>  "
+     "  <assem_size>1</assem_size>  "
+     "  <n_assem_core>7</n_assem_core>  "
+     "  <n_assem_batch>3</n_assem_batch>  "
+     "  <power_cap>100</power_cap>  "
+     ""
+     "  <side_products> <val>process_heat</val> </side_products>"
+     "  <side_product_quantity> <val>10</val> </side_product_quantity>";
+
+  int simdur = 23;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  sim.AddSource("uox").Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("spentuox", c_spentuox());
+  sim.Run();
+
+  std::vector<double> power(simdur, -1);
+  QueryResult qr = sim.db().Query("TimeSeriesPower", NULL);
+  ASSERT_EQ(simdur, qr.rows.size());
+  for (int i = 0; i < qr.rows.size(); i++) {
+    power[qr.GetVal<int>("Time", i)] = qr.GetVal<double>("Value", i);
+  }
+  std::vector<double> heat(simdur, -1);
+  qr = sim.db().Query("ReactorSideProducts", NULL);
+  ASSERT_EQ(simdur, qr.rows.size());
+  for (int i = 0; i < qr.rows.size(); i++) {
+    heat[qr.GetVal<int>("Time", i)] = qr.GetVal<double>("Value", i);
+  }
+
+  config += "<interval_output>1</interval_output>";
+  cyclus::MockSim isim(cyclus::AgentSpec(":cycamore:Reactor"), config, simdur);
+  isim.AddSource("uox").Finalize();
+  isim.AddRecipe("uox", c_uox());
+  isim.AddRecipe("spentuox", c_spentuox());
+  isim.Run();
+
+  // per time step rows are replaced, not duplicated
+  std::set<std::string> tables = isim.db().Tables();
+  EXPECT_EQ(0, tables.count("TimeSeriesPower"));
+  EXPECT_EQ(0, tables.count("TimeSeriessupplyPOWER"));
+  EXPECT_EQ(0, tables.count("ReactorSideProducts"));
+
+  // one interval per run of equal power values
+  int nruns = 1;
+  for (int t = 1; t < simdur; t++) {
+    nruns += power[t] != power[t - 1];
+  }
+  qr = isim.db().Query("ReactorPowerIntervals", NULL);
+  EXPECT_GT(simdur / 2, qr.rows.size());
+  EXPECT_EQ(nruns, qr.rows.size());
+  int tot = 0;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    int start = qr.GetVal<int>("StartTime", i);
+    int end = qr.GetVal<int>("EndTime", i);
+    for (int t = start; t < end; t++) {
+      EXPECT_DOUBLE_EQ(power[t], qr.GetVal<double>("Value", i)) << "t=" << t;
+    }
+    tot += end - start;
+  }
+  EXPECT_EQ(simdur, tot);
+
+  qr = isim.db().Query("ReactorSideProductIntervals", NULL);
+  EXPECT_EQ(nruns, qr.rows.size());
+  tot = 0;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    int start = qr.GetVal<int>("StartTime", i);
+    int end = qr.GetVal<int>("EndTime", i);
+    for (int t = start; t < end; t++) {
+      EXPECT_DOUBLE_EQ(heat[t], qr.GetVal<double>("Value", i)) << "t=" << t;
+    }
+    tot += end - start;
+  }
+  EXPECT_EQ(simdur, tot);
+}
+
 TEST(ReactorTests, MultipleByProduct) {
   std::string config =
      "  <fuel_inrecipes>  <val>uox</val>      </fuel_inrecipes>  "
@@ -879,5 +1391,78 @@ TEST(ReactorTests, MultipleByProduct) {
 }
 
 } // namespace reactortests
+
+class ReactorTest : public ::testing::Test {
+ protected:
+  cyclus::TestContext tc_;
+  Reactor* r_;
+
+  virtual void SetUp() {
+    r_ = new Reactor(tc_.get());
+    r_->fuel_outcommods.push_back("waste1");
+    r_->fuel_outcommods.push_back("waste2");
+  }
+
+  virtual void TearDown() { delete r_; }
+
+  Material::Ptr NewSpent(double qty, int i) {
+    Material::Ptr m = Material::CreateUntracked(qty, reactortests::c_spentuox());
+    r_->res_index_map_.Set(m->obj_id(), i);
+    return m;
+  }
+
+  void PushSpent(Material::Ptr m) {
+    r_->PushSpent(cyclus::toolkit::MatVec(1, m));
+  }
+
+  void PopSpent(const std::set<int>& obj_ids) { r_->PopSpent(obj_ids); }
+
+  double SpentQty(std::string commod) { return r_->SpentQty(commod); }
+
+  double SpentBufQty() { return r_->spent.quantity(); }
+};
+
+// the per-outcommod spent fuel totals must keep matching the spent buffer
+// through many pushes and pops of assemblies with inexact quantities, and
+// drop to exactly zero once everything is gone.
+TEST_F(ReactorTest, SpentQtyTracking) {
+  EXPECT_EQ(0, SpentQty("waste1"));  // builds the index
+
+  std::deque<Material::Ptr> held;
+  for (int t = 0; t < 200; t++) {
+    for (int i = 0; i < 3; i++) {
+      Material::Ptr m = NewSpent(0.1 * (t % 7 + i + 1), (t + i) % 2);
+      PushSpent(m);
+      held.push_back(m);
+    }
+
+    // pop every other held assembly from the front half
+    std::set<int> ids;
+    for (int i = 0; i < held.size() / 2; i += 2) {
+      ids.insert(held[i]->obj_id());
+    }
+    std::deque<Material::Ptr> keep;
+    for (int i = 0; i < held.size(); i++) {
+      if (ids.count(held[i]->obj_id()) == 0) {
+        keep.push_back(held[i]);
+      }
+    }
+    held.swap(keep);
+    PopSpent(ids);
+
+    double tot = SpentQty("waste1") + SpentQty("waste2");
+    ASSERT_NEAR(SpentBufQty(), tot, 1e-9) << "t=" << t;
+  }
+
+  std::set<int> ids;
+  for (int i = 0; i < held.size(); i++) {
+    ids.insert(held[i]->obj_id());
+  }
+  PopSpent(ids);
+  EXPECT_EQ(0, SpentBufQty());
+  EXPECT_EQ(0, SpentQty("waste1"));
+  EXPECT_EQ(0, SpentQty("waste2"));
+}
+
 } // namespace cycamore
 